@@ -0,0 +1,35 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+
+// Replaces the global operator new/delete, every other form (arrays, nothrow) goes through these
+static std::atomic<uint64_t> s_allocations{0};
+static std::atomic<bool> s_counting{false};
+
+uint64_t GetAllocationCount() {
+    return s_allocations.load(std::memory_order_relaxed);
+}
+
+void SetAllocationCounting(bool enabled) {
+    s_counting.store(enabled, std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size) {
+    if (s_counting.load(std::memory_order_relaxed)) {
+        s_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
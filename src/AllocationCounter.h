@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+
+// Number of heap allocations (global operator new) made while counting was on.
+// Used by --bench to show a code path doesn't allocate
+uint64_t GetAllocationCount();
+// Off by default, so normal play doesn't pay for a shared counter on every allocation. --bench turns it on
+void SetAllocationCounting(bool enabled);
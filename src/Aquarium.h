@@ -1,3 +1,4 @@
+#pragma once
 #define NOMINMAX // To avoid min/max macro conflict on Windows
 
 #include <vector>
@@ -5,16 +6,13 @@
 #include <iostream>
 #include <algorithm>
 #include "Core.h"
-
-
-enum class AquariumCreatureType {
-    NPCreature,
-    BiggerFish,
-    FastNPCreature,   //added new fish species
-    NewNemoCreature,   //added new fish species
-    SharkCreature      //added final new fish species
-};
-
+#include "SpatialHash.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include "Random.h"
+#include "InputRecording.h"
+#include "InputQueue.h"
 
 
 // Health power up subclass
@@ -42,6 +40,14 @@ class AquariumLevelPopulationNode{
         int currentPopulation;
 };
 
+// What AquariumLevel::Load reads out of a snapshot, Restore puts it in place
+struct AquariumLevelSnapshot {
+    int levelScore = 0;
+    int powerUpScore = 0;
+    bool dirty = true;
+    std::vector<int> currentPopulation; // one per population node
+};
+
 class AquariumLevel : public GameLevel {
     public:
     // Added a powerup target score as a parameter for the class and its parametrized constructor
@@ -55,36 +61,69 @@ class AquariumLevel : public GameLevel {
         //Changed this function from virtual to non virtual since it will be implemented in this class
         //The classes that inherit from it will receive it directly, no needed to override
         //Went from a polymorphic behavior to a more inheritance behavior
-        std::vector<AquariumCreatureType> Repopulate();
+        // fills toSpawn with how many creatures of each type are missing and returns the total.
+        // Only has work to do after something was eaten or reset, see needsRepopulate()
+        int Repopulate(int toSpawn[kAquariumCreatureTypeCount]);
+        bool needsRepopulate() const { return m_dirty; }
+        int getPopulation(AquariumCreatureType creatureType) const; // target population of the type
+        int getTotalPopulation() const;
         
         // powerup functions
         bool canSpawnPowerUp() override;
         void setPowerUpScore(int score) { m_power_up_score = score; }
         int getPowerUpScore() { return this->m_power_up_score; }
+        // NEW_LEVEL goes here once the target score is reached
+        void setEventQueue(GameEventQueue* events) { m_events = events; }
+        // scores and what is alive of each population node, Load fails if the level has different nodes.
+        // Load only reads and checks, the level changes in Restore
+        void Save(SnapshotWriter& out) const;
+        bool Load(SnapshotReader& in, AquariumLevelSnapshot& state) const;
+        void Restore(const AquariumLevelSnapshot& state);
     protected:
+        void addPopulation(AquariumCreatureType creatureType, int population);
         std::vector<std::shared_ptr<AquariumLevelPopulationNode>> m_levelPopulation;
+        AquariumLevelPopulationNode* m_populationOf[kAquariumCreatureTypeCount] = {}; // node of each type, null if the level has none
         int m_level_score;
         int m_targetScore;
         int m_power_up_score;
+        GameEventQueue* m_events = nullptr;
+        bool m_dirty = true; // a population node changed since the last Repopulate
 
 };
 
 
+// Speeds were tuned per frame at 60 fps, with NPCs only moving every 6th frame (AwaitFrames{5}).
+// The fixed timestep scales movement by these so the game plays the same at any tick rate
+const float kReferenceFrameRate = 60.0f;
+const float kNpcStepRate = 10.0f;
+
+// What PlayerCreature::Load reads out of a snapshot, Restore puts it in place
+struct PlayerSnapshot {
+    CreatureStore store; // the player's single row
+    int score = 0;
+    int lives = 3;
+    int power = 1;
+    float damageDebounce = 0;
+    float step = 1.0f;
+};
+
 class PlayerCreature : public Creature {
 public:
-    double deltaTime = 0;
-
     PlayerCreature(float x, float y, int speed, std::shared_ptr<GameSprite> sprite);
     void move();
     void draw() const;
-    void update();
+    void draw(float alpha) const; // alpha: 0 at the previous tick's position, 1 at the current one
+    void update(float seconds);
     void changeSpeed(int speed);
     void setLives(int lives) { m_lives = lives; }
     void setDirection(float dx, float dy);
-    float isXDirectionActive() { return m_dx != 0; }
-    float isYDirectionActive() {return m_dy != 0; }
-    float getDx() { return m_dx; }
-    float getDy() { return m_dy; }
+    // the player's input right now, and putting it back exactly (see InputRecording.h)
+    InputRecord CaptureInput(uint32_t tick) const;
+    void ApplyInput(const InputRecord& input);
+    float isXDirectionActive() { return m_store->dx[m_row] != 0; }
+    float isYDirectionActive() {return m_store->dy[m_row] != 0; }
+    float getDx() { return m_store->dx[m_row]; }
+    float getDy() { return m_store->dy[m_row]; }
 
     int getScore()const { return m_score; }
     int getLives() const { return m_lives; }
@@ -92,67 +131,70 @@ public:
     
     void addToScore(int amount, int weight=1) { m_score += amount * weight; }
     void gainLive();
-    void loseLife(int debounce);
+    void loseLife(float debounceSeconds);
     void increasePower(int value) { m_power += value; }
-    void reduceDamageDebounce();
+    void reduceDamageDebounce(float seconds);
+    void Save(SnapshotWriter& out) const;
+    bool Load(SnapshotReader& in, PlayerSnapshot& state) const;
+    void Restore(PlayerSnapshot& state);
     
 private:
     int m_score = 0;
     int m_lives = 3;
     int m_power = 1; // mark current power lvl
-    int m_damage_debounce = 0; // frames to wait after eating
+    float m_damage_debounce = 0; // seconds to wait after getting hurt
+    float m_step = 1.0f; // fraction of a 60 fps frame the current tick covers
 };
 
 class NPCreature : public Creature {
 public:
     NPCreature(float x, float y, int speed, std::shared_ptr<GameSprite> sprite);
-    AquariumCreatureType GetType() {return this->m_creatureType;}
+    // View over a row of an aquarium's creature store
+    NPCreature(std::shared_ptr<CreatureStore> store, size_t row, std::shared_ptr<GameSprite> sprite)
+    : Creature(std::move(store), row, std::move(sprite)) {}
+    AquariumCreatureType GetType() {return m_store->type[m_row];}
+    // species movement lives in CreatureStore::Move, the row's type picks it
     void move() override;
     void draw() const override;
 protected:
-    AquariumCreatureType m_creatureType;
-
+    NPCreature(float x, float y, int speed, std::shared_ptr<GameSprite> sprite, AquariumCreatureType type);
 };
 
 class BiggerFish : public NPCreature {
 public:
     BiggerFish(float x, float y, int speed, std::shared_ptr<GameSprite> sprite);
-    void move() override;
-    void draw() const override;
 };
 //New fish species that inherits from NPCreature class
 class FastNPCreature : public NPCreature {
 public:
     FastNPCreature(float x, float y, int speed, std::shared_ptr<GameSprite> sprite);
-    void move() override; //Since movement behaviour will be different, must overide this from parent class
 };
 
 //New fish species that inherits from NPCreature class
 class NewNemoCreature : public NPCreature {
 public:
     NewNemoCreature(float x, float y, int speed, std::shared_ptr<GameSprite> sprite);
-    void move() override;  
 };
 // New Shark species that inherits from NPCreature class
+// Its boost/rest timers are kept as sparse per type state in the store
 class SharkCreature : public NPCreature {
 public:
     SharkCreature(float x, float y, int speed, std::shared_ptr<GameSprite> sprite);
-    void move() override; //Since movement behaviour will be different, must overide this from parent class
-private:
-    //Declared and initialized both variables for future use in override of move() for timers
-    int boostTimer = 10;   
-    int restTimer = 5;
 };
 
 
 class AquariumSpriteManager {
     public:
-        AquariumSpriteManager();
+        // uploadTextures=false only describes the atlas, used by the --bake-assets step
+        AquariumSpriteManager(bool uploadTextures = true);
         ~AquariumSpriteManager() = default;
+        const std::shared_ptr<SpriteAtlas>& getAtlas() const { return m_atlas; }
         std::shared_ptr<GameSprite>GetSprite(AquariumCreatureType t);
         // Added powerup sprite getter and parameters
         std::shared_ptr<GameSprite>GetSprite(PowerUpType t);
     private:
+        std::shared_ptr<GameSprite> AddSprite(const std::string& imagePath, int width, int height);
+        std::shared_ptr<SpriteAtlas> m_atlas; // every creature and powerup sprite lives in this one page
         std::shared_ptr<GameSprite> m_npc_fish;
         std::shared_ptr<GameSprite> m_big_fish;
         std::shared_ptr<GameSprite> m_fast_fish; //added new fist species for future implementation
@@ -162,19 +204,50 @@ class AquariumSpriteManager {
 };
 
 
+// Bytes used per subsystem, so the footprint can be tracked in long sessions (M key / level changes)
+struct AquariumMemoryReport {
+    size_t spriteTextureBytes = 0;   // gpu, shared atlas pages
+    size_t spriteCpuBytes = 0;       // decoded pixels still held on the cpu (should be 0 after upload)
+    size_t spriteInstanceBytes = 0;  // the per creature GameSprite objects
+    size_t creatureBytes = 0;
+    size_t powerUpBytes = 0;
+    void print() const;
+};
+
+// What Aquarium::Load reads out of a snapshot, Restore swaps it in
+struct AquariumSnapshot {
+    struct PlacedPowerUp {
+        PowerUpType type;
+        float x;
+        float y;
+    };
+    int currentLevel = 0;
+    int maxPopulation = 0;
+    bool canCollidePowerUp = false;
+    uint64_t seed = 1;
+    Random spawnRandom;
+    Random powerUpRandom;
+    CreatureStore store;
+    SpatialHash grid;
+    std::vector<PlacedPowerUp> powerUps;
+    std::vector<AquariumLevelSnapshot> levels;
+};
+
 class Aquarium{
 public:
     Aquarium(int width, int height, std::shared_ptr<AquariumSpriteManager> spriteManager);
     void addCreature(std::shared_ptr<Creature> creature);
     void addAquariumLevel(std::shared_ptr<AquariumLevel> level);
-    void removeCreature(std::shared_ptr<Creature> creature);
+    void removeCreature(CreatureHandle creature);
     void clearCreatures();
-    void update();
-    void draw() const;
-    void setBounds(int w, int h) { m_width = w; m_height = h; }
+    void update(float seconds);
+    void draw(float alpha = 1.0f) const;
+    void setBounds(int w, int h) { m_width = w; m_height = h; m_store->setBounds(w - 20, h - 20); m_grid.Resize(w - 20, h - 20, *m_store); }
     void setMaxPopulation(int n) { m_maxPopulation = n; }
     void Repopulate();
-    void SpawnCreature(AquariumCreatureType type);
+    void SpawnCreature(AquariumCreatureType type) { this->SpawnCreatures(type, 1); }
+    // count creatures of one type in one pass: positions rolled together, store grown once
+    void SpawnCreatures(AquariumCreatureType type, int count);
     // powerup functions
     void addPowerUp(std::shared_ptr<PowerUp> power);
     void SpawnPowerUp(PowerUpType type);
@@ -184,51 +257,144 @@ public:
     void clearPowerUps();
     std::shared_ptr<PowerUp> getPowerUpAt(int index);
     
-    std::shared_ptr<Creature> getCreatureAt(int index);
-    int getCreatureCount() const { return m_creatures.size(); }
+    // handle of the creature in that row, invalid past the end. Its fields are read through getCreatureStore(),
+    // nothing is built or allocated per call
+    CreatureHandle getCreatureAt(int index) const;
+    int getCreatureCount() const { return m_store->size(); }
+    const CreatureStore& getCreatureStore() const { return *m_store; }
+    const SpatialHash& getSpatialHash() const { return m_grid; }
+    // the aquarium, its levels and the scene publish here, the scene drains it every tick
+    GameEventQueue& getEvents() { return m_events; }
+    // rows the grid hands back around the player, reused by DetectAquariumCollisions every frame
+    std::vector<size_t>& getNearbyScratch() { return m_nearby; }
     int getWidth() const { return m_width; }
     int getHeight() const { return m_height; }
+    int getCurrentLevel() const { return currentLevel; } // counts up, not wrapped to the level list
+    // reseeds every random stream of the aquarium (spawns, power ups, creatures), same seed same run
+    void setSeed(uint64_t seed);
+    uint64_t getSeed() const { return m_seed; }
+    AquariumMemoryReport GetMemoryReport() const;
+    // the whole simulation state: creatures, grid, power ups, levels and random streams. Restoring continues the
+    // run exactly where it was saved, it has to be an aquarium of the same size with the same levels.
+    // Load only reads and checks the snapshot into state, nothing of the aquarium changes until Restore
+    void Save(SnapshotWriter& out) const;
+    bool Load(SnapshotReader& in, AquariumSnapshot& state) const;
+    void Restore(AquariumSnapshot& state);
 
 
 private:
+    void PlacePowerUp(PowerUpType type, float x, float y); // from the pool if there's a free one
+    void ReservePools(); // creature rows, shark state and grid slots for the most crowded level
     int m_maxPopulation = 0;
     int m_width;
     int m_height;
     int currentLevel = 0;
-    std::vector<std::shared_ptr<Creature>> m_creatures;
-    std::vector<std::shared_ptr<Creature>> m_next_creatures;
+    std::shared_ptr<CreatureStore> m_store; // every creature of the aquarium, one array per field
+    SpatialHash m_grid; // collision broadphase over m_store's rows, kept in sync on add/remove/move
+    GameEventQueue m_events;
+    ThreadPool m_pool; // movement is split across it once there are enough creatures
+    std::vector<size_t> m_nearby;
+    uint64_t m_seed = 1;
+    Random m_spawnRandom;
+    Random m_powerUpRandom;
+    std::shared_ptr<GameSprite> m_type_sprites[kAquariumCreatureTypeCount]; // one shared sprite per species
     std::vector<std::shared_ptr<AquariumLevel>> m_aquariumlevels;
     std::shared_ptr<AquariumSpriteManager> m_sprite_manager;
+    mutable SpriteBatch m_batch; // creatures and powerups share the sprite atlas, so they go out in one draw
     // powerup properties
-    bool m_canCollidePowerUp;
+    bool m_canCollidePowerUp = false;
     std::vector<std::shared_ptr<PowerUp>> m_power_ups;
+
+    // Pools: creature rows are reserved for the most crowded level (see addAquariumLevel) and a level change
+    // only clears them, so after every level has been played once spawning reuses the same storage.
+    // Picked/cleared power ups wait in m_free_power_ups for the next spawn, all of them share one sprite
+    std::vector<std::shared_ptr<PowerUp>> m_free_power_ups;
+    std::shared_ptr<GameSprite> m_health_sprite;
+    // spawn positions/speeds of a batch, reused between batches
+    std::vector<float> m_spawnX;
+    std::vector<float> m_spawnY;
+    std::vector<int> m_spawnSpeed;
 };
 
-// function to determine when the player picks up a powerup
-std::shared_ptr<GameEvent> DetectPowerUpCollisions(std::shared_ptr<Aquarium> aquarium, std::shared_ptr<PlayerCreature> player);
+// function to determine when the player picks up a powerup, publishes a POWERUP event
+bool DetectPowerUpCollisions(std::shared_ptr<Aquarium> aquarium, std::shared_ptr<PlayerCreature> player);
 
 
-std::shared_ptr<GameEvent> DetectAquariumCollisions(std::shared_ptr<Aquarium> aquarium, std::shared_ptr<PlayerCreature> player);
+// publishes a COLLISION for every creature overlapping the player. Returns how many were published
+size_t DetectAquariumCollisions(std::shared_ptr<Aquarium> aquarium, std::shared_ptr<PlayerCreature> player);
 
 
 class AquariumGameScene : public GameScene {
     public:
         AquariumGameScene(std::shared_ptr<PlayerCreature> player, std::shared_ptr<Aquarium> aquarium, string name)
         : m_player(std::move(player)) , m_aquarium(std::move(aquarium)), m_name(name){}
-        std::shared_ptr<GameEvent> GetLastEvent(){return m_lastEvent;}
-        void SetLastEvent(std::shared_ptr<GameEvent> event){this->m_lastEvent = event;}
+        const GameEvent& GetLastEvent(){return m_lastEvent;}
+        void SetLastEvent(const GameEvent& event){this->m_lastEvent = event;}
         std::shared_ptr<PlayerCreature> GetPlayer(){return this->m_player;}
         std::shared_ptr<Aquarium> GetAquarium(){return this->m_aquarium;}
         string GetName()override {return this->m_name;}
         void Update() override;
         void Draw() override;
+        void DrawHud() override;
+        uint64_t GetHudKey() const override; // score, power, lives and whether the font is in
+        // the panel's text is drawn with font once it's loaded (bitmap text until then), it has to outlive the scene
+        void SetHudFont(const ofTrueTypeFont* font) { m_hudFont = font; }
+        // the level's first population, spawned while the intro is still up
+        void Preload() override;
+        // simulation rate, independent of the frame rate (60 by default)
+        void SetTickRate(double ticksPerSecond) { m_clock.setTickRate(ticksPerSecond); }
+        double GetTickRate() const { return m_clock.getTickRate(); }
+        // runs ticks fixed ticks right away, no clock involved (headless runs)
+        void Simulate(int ticks);
+        // ticks simulated so far, recorded input is stamped with it
+        long long GetTick() const { return m_tick; }
+        // plays recorded input back, each record right before the tick it was recorded at.
+        // The keyboard has to stay off the player meanwhile
+        void SetReplay(std::vector<InputRecord> inputs) { m_replay = std::move(inputs); m_nextInput = 0; }
+        bool IsReplaying() const { return !m_replay.empty(); }
+        // arrow key events from the window, turned into the player's direction right before the next tick.
+        // However many arrive in a frame, the player only moves in its update. Ignored during a replay
+        bool PushInput(int key, bool pressed, uint64_t micros);
+        // the direction changes the keys made go to recorder, stamped with their tick
+        void SetRecorder(InputRecorder* recorder) { m_recorder = recorder; }
+        // call once a frame is drawn: the input applied since the last call counts as on screen, its latency
+        // (key callback to the end of the draw) goes to the profiler's input latency phase
+        void PresentInput(uint64_t micros);
+        void PrintInputLatency() const;
+        // the scene's tick and the player on top of Aquarium::Save, see Snapshot.h
+        bool SaveSnapshot(const std::string& path) const;
+        bool LoadSnapshot(const std::string& path);
     private:
-        void paintAquariumHUD();
+        void ApplyInputCommands();
+        void Tick(float seconds);
+        void HandleEvents();
         std::shared_ptr<PlayerCreature> m_player;
         std::shared_ptr<Aquarium> m_aquarium;
-        std::shared_ptr<GameEvent> m_lastEvent;
+        GameEvent m_lastEvent; // only GAME_OVER ends up here
+        size_t m_droppedEvents = 0; // the queue's drop count last time it was drained
         string m_name;
-        AwaitFrames updateControl{5};
+        FixedTimestep m_clock;
+        float m_alpha = 1.0f; // how far the current frame is between the last two ticks
+        long long m_tick = 0;
+        std::vector<InputRecord> m_replay;
+        size_t m_nextInput = 0;
+        InputQueue m_input;
+        InputRecorder* m_recorder = nullptr;
+        uint8_t m_heldKeys = 0; // arrows held down, kHeld* bits
+        int m_lastX = 0;        // direction of the latest left/right press, wins while both are held
+        int m_lastY = 0;
+        int m_dirX = 0;         // direction the keys gave the player last
+        int m_dirY = 0;
+        uint64_t m_unpresentedInput = 0; // key time of the oldest input applied but not drawn yet, 0 if none
+        uint64_t m_latencyCount = 0;
+        uint64_t m_latencyTotal = 0;
+        uint64_t m_latencyMax = 0;
+        // score panel, each widget's mesh is only rebuilt when its value changes (positions are set in DrawHud)
+        const ofTrueTypeFont* m_hudFont = nullptr;
+        HudText m_scoreText{"Score: ", 0, 0, [this]() { return m_player->getScore(); }};
+        HudText m_powerText{"Power: ", 0, 0, [this]() { return m_player->getPower(); }};
+        HudText m_livesText{"Lives: ", 0, 0, [this]() { return m_player->getLives(); }};
+        HudCircles m_livesCircles{0, 0, 5, 20, ofColor::red, [this]() { return m_player->getLives(); }};
 };
 
 //Added new fish species in order for it to be rendered accordingly to the level
@@ -236,17 +402,17 @@ class AquariumGameScene : public GameScene {
 class Level_0 : public AquariumLevel  {
     public:
         Level_0(int levelNumber, int targetScore, int powerUpScore): AquariumLevel(levelNumber, targetScore, powerUpScore){
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::NPCreature, 8));
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::NewNemoCreature, 4));
+            this->addPopulation(AquariumCreatureType::NPCreature, 8);
+            this->addPopulation(AquariumCreatureType::NewNemoCreature, 4);
         };
 
 };
 class Level_1 : public AquariumLevel  {
     public:
         Level_1(int levelNumber, int targetScore, int powerUpScore): AquariumLevel(levelNumber, targetScore, powerUpScore){
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::NPCreature, 12));
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::NewNemoCreature, 6));
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::FastNPCreature, 6));
+            this->addPopulation(AquariumCreatureType::NPCreature, 12);
+            this->addPopulation(AquariumCreatureType::NewNemoCreature, 6);
+            this->addPopulation(AquariumCreatureType::FastNPCreature, 6);
             
         };
 
@@ -256,9 +422,9 @@ class Level_1 : public AquariumLevel  {
 class Level_2 : public AquariumLevel  {
     public:
         Level_2(int levelNumber, int targetScore, int powerUpScore): AquariumLevel(levelNumber, targetScore, powerUpScore){
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::NPCreature, 30));
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::BiggerFish, 2));
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::FastNPCreature, 8));
+            this->addPopulation(AquariumCreatureType::NPCreature, 30);
+            this->addPopulation(AquariumCreatureType::BiggerFish, 2);
+            this->addPopulation(AquariumCreatureType::FastNPCreature, 8);
             
 
         };
@@ -269,9 +435,9 @@ class Level_2 : public AquariumLevel  {
 class Level_3 : public AquariumLevel {
     public:
     Level_3(int levelNumber, int targetScore, int powerUpScore): AquariumLevel(levelNumber, targetScore, powerUpScore){
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::BiggerFish, 20));
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::FastNPCreature, 20));
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::SharkCreature, 6));
+            this->addPopulation(AquariumCreatureType::BiggerFish, 20);
+            this->addPopulation(AquariumCreatureType::FastNPCreature, 20);
+            this->addPopulation(AquariumCreatureType::SharkCreature, 6);
             
         };
 
@@ -281,10 +447,13 @@ class Level_3 : public AquariumLevel {
 class Level_4 : public AquariumLevel {
 public:
     Level_4(int levelNumber, int targetScore, int powerUpScore): AquariumLevel(levelNumber, targetScore, powerUpScore){
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::BiggerFish, 5));
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::FastNPCreature, 5));
-             this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::SharkCreature, 15));
+            this->addPopulation(AquariumCreatureType::BiggerFish, 5);
+            this->addPopulation(AquariumCreatureType::FastNPCreature, 5);
+             this->addPopulation(AquariumCreatureType::SharkCreature, 15);
         };
 
 
 };
+
+// The game's five levels with their target and power up scores, shared by the window and --headless
+void AddGameLevels(std::shared_ptr<Aquarium> aquarium);
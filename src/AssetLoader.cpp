@@ -0,0 +1,80 @@
+#include "AssetLoader.h"
+
+
+AssetLoader::~AssetLoader() {
+    for (std::thread& worker : m_workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void AssetLoader::QueueAtlas(const std::string& name, std::shared_ptr<SpriteAtlas> atlas) {
+    if (m_started) return; // the item list is fixed once the workers run
+    m_items.push_back({name, std::move(atlas), nullptr});
+}
+
+void AssetLoader::QueueOnMainThread(const std::string& name, std::function<void()> job) {
+    if (m_started) return;
+    m_items.push_back({name, nullptr, std::move(job)});
+}
+
+void AssetLoader::Start(int workers) {
+    if (m_started) return;
+    m_started = true;
+    if (workers <= 0) {
+        workers = std::max(1u, std::min(4u, std::thread::hardware_concurrency()));
+    }
+    for (int i = 0; i < workers; ++i) {
+        m_workers.emplace_back(&AssetLoader::WorkerLoop, this);
+    }
+}
+
+// each worker grabs the next atlas nobody has taken yet
+void AssetLoader::WorkerLoop() {
+    while (true) {
+        size_t index = m_nextToDecode++;
+        if (index >= m_items.size()) return;
+        Item& item = m_items[index];
+        if (!item.atlas) continue;
+        item.atlas->Decode();
+        std::lock_guard<std::mutex> lock(m_decodedMutex);
+        m_decoded.push_back(index);
+    }
+}
+
+void AssetLoader::Update() {
+    if (!m_started || this->IsDone()) return;
+
+    // uploads are cheap compared to decoding, do all that are ready
+    std::vector<size_t> ready;
+    {
+        std::lock_guard<std::mutex> lock(m_decodedMutex);
+        ready.swap(m_decoded);
+    }
+    for (size_t index : ready) {
+        m_items[index].atlas->Upload();
+        m_items[index].resident = true;
+        ++m_completed;
+    }
+
+    // only one main thread job per frame so the intro keeps drawing
+    for (Item& item : m_items) {
+        if (item.job && !item.resident) {
+            item.job();
+            item.resident = true;
+            ++m_completed;
+            break;
+        }
+    }
+}
+
+float AssetLoader::GetProgress() const {
+    if (m_items.empty()) return 1.0f;
+    return float(m_completed) / m_items.size();
+}
+
+bool AssetLoader::IsResident(const std::string& name) const {
+    for (const Item& item : m_items) {
+        if (item.name == name) return item.resident;
+    }
+    return false;
+}
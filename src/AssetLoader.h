@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "Core.h"
+
+
+// Loads assets in the background while the intro is already on screen.
+// Atlases are decoded on worker threads, only their texture upload happens on the main thread (in Update()).
+// Things that can't leave the main thread (fonts, sound) are queued as jobs and run one per frame
+class AssetLoader {
+public:
+    AssetLoader() = default;
+    ~AssetLoader();
+
+    void QueueAtlas(const std::string& name, std::shared_ptr<SpriteAtlas> atlas);
+    void QueueOnMainThread(const std::string& name, std::function<void()> job);
+    void Start(int workers = 0);
+
+    // main thread, once per frame
+    void Update();
+
+    float GetProgress() const;
+    bool IsDone() const { return m_completed == m_items.size(); }
+    bool IsResident(const std::string& name) const;
+
+private:
+    struct Item {
+        std::string name;
+        std::shared_ptr<SpriteAtlas> atlas; // null for main thread jobs
+        std::function<void()> job;
+        bool resident = false;
+    };
+    void WorkerLoop();
+
+    std::vector<Item> m_items;
+    std::vector<std::thread> m_workers;
+    std::atomic<size_t> m_nextToDecode{0};
+    std::mutex m_decodedMutex;
+    std::vector<size_t> m_decoded; // decoded on a worker, waiting for the upload
+    size_t m_completed = 0;
+    bool m_started = false;
+};
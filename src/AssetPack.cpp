@@ -0,0 +1,198 @@
+#include "AssetPack.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+// MappedFile
+MappedFile::~MappedFile() {
+    this->Close();
+}
+
+bool MappedFile::Open(const std::string& path) {
+    this->Close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER size;
+        GetFileSizeEx(file, &size);
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (view != nullptr) {
+            m_file = file;
+            m_mapping = mapping;
+            m_data = static_cast<const unsigned char*>(view);
+            m_size = size_t(size.QuadPart);
+            m_mapped = true;
+            return true;
+        }
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+    }
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* view = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd); // the mapping keeps the file alive
+            if (view != MAP_FAILED) {
+                m_data = static_cast<const unsigned char*>(view);
+                m_size = size_t(st.st_size);
+                m_mapped = true;
+                return true;
+            }
+        } else {
+            ::close(fd);
+        }
+    }
+#endif
+    // no mapping, just read the file
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    m_fallback.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    if (m_fallback.empty()) return false;
+    m_data = m_fallback.data();
+    m_size = m_fallback.size();
+    return true;
+}
+
+void MappedFile::Close() {
+    if (m_mapped) {
+#ifdef _WIN32
+        UnmapViewOfFile(m_data);
+        CloseHandle(m_mapping);
+        CloseHandle(m_file);
+        m_mapping = nullptr;
+        m_file = nullptr;
+#else
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+    }
+    m_fallback.clear();
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+}
+
+
+// AssetPack
+bool AssetPack::Open(const std::string& path) {
+    if (!m_file.Open(path)) return false;
+
+    // validate everything up front so lookups later don't need to
+    if (m_file.size() < sizeof(AssetPackHeader)) return false;
+    m_header = reinterpret_cast<const AssetPackHeader*>(m_file.data());
+    if (std::memcmp(m_header->magic, "AQPK", 4) != 0 || m_header->version != kAssetPackVersion) {
+        std::cerr << "Asset pack " << path << " has the wrong format or version" << std::endl;
+        m_file.Close();
+        return false;
+    }
+    size_t indexEnd = sizeof(AssetPackHeader)
+                    + size_t(m_header->imageCount) * sizeof(AssetPackImage)
+                    + size_t(m_header->regionCount) * sizeof(AssetPackRegion);
+    if (indexEnd > m_file.size()) {
+        m_file.Close();
+        return false;
+    }
+    m_images = reinterpret_cast<const AssetPackImage*>(m_file.data() + sizeof(AssetPackHeader));
+    m_regions = reinterpret_cast<const AssetPackRegion*>(m_images + m_header->imageCount);
+    for (uint32_t i = 0; i < m_header->imageCount; ++i) {
+        const AssetPackImage& image = m_images[i];
+        uint64_t bytes = uint64_t(image.width) * image.height * 4;
+        if (image.offset + bytes > m_file.size() || image.firstRegion + image.regionCount > m_header->regionCount) {
+            std::cerr << "Asset pack " << path << " is truncated" << std::endl;
+            m_file.Close();
+            return false;
+        }
+    }
+    return true;
+}
+
+const AssetPackImage* AssetPack::FindImage(const std::string& name) const {
+    if (!m_file.isOpen()) return nullptr;
+    for (uint32_t i = 0; i < m_header->imageCount; ++i) {
+        if (std::strncmp(m_images[i].name, name.c_str(), sizeof(m_images[i].name)) == 0) {
+            return &m_images[i];
+        }
+    }
+    return nullptr;
+}
+
+const AssetPackRegion* AssetPack::GetRegions(const AssetPackImage& image) const {
+    return m_regions + image.firstRegion;
+}
+
+const unsigned char* AssetPack::GetPixels(const AssetPackImage& image) const {
+    return m_file.data() + image.offset;
+}
+
+
+// AssetPackWriter
+void AssetPackWriter::AddImage(const std::string& name, int width, int height,
+                               const std::vector<AssetPackRegion>& regions, const unsigned char* rgba) {
+    Entry entry;
+    entry.name = name;
+    entry.width = width;
+    entry.height = height;
+    entry.regions = regions;
+    entry.pixels.assign(rgba, rgba + size_t(width) * height * 4);
+    m_entries.push_back(std::move(entry));
+}
+
+bool AssetPackWriter::Write(const std::string& path) const {
+    AssetPackHeader header;
+    std::memcpy(header.magic, "AQPK", 4);
+    header.version = kAssetPackVersion;
+    header.imageCount = m_entries.size();
+    header.regionCount = 0;
+    for (const Entry& entry : m_entries) header.regionCount += entry.regions.size();
+
+    auto align = [](uint64_t v) { return (v + 15) & ~uint64_t(15); };
+    uint64_t offset = align(sizeof(AssetPackHeader) + header.imageCount * sizeof(AssetPackImage)
+                            + header.regionCount * sizeof(AssetPackRegion));
+
+    std::vector<AssetPackImage> images;
+    std::vector<AssetPackRegion> regions;
+    for (const Entry& entry : m_entries) {
+        AssetPackImage image;
+        std::memset(&image, 0, sizeof(image));
+        if (entry.name.size() >= sizeof(image.name)) {
+            std::cerr << "Asset name too long for the pack: " << entry.name << std::endl;
+            return false;
+        }
+        std::strncpy(image.name, entry.name.c_str(), sizeof(image.name) - 1);
+        image.width = entry.width;
+        image.height = entry.height;
+        image.firstRegion = regions.size();
+        image.regionCount = entry.regions.size();
+        image.offset = offset;
+        offset = align(offset + entry.pixels.size());
+        images.push_back(image);
+        regions.insert(regions.end(), entry.regions.begin(), entry.regions.end());
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(images.data()), images.size() * sizeof(AssetPackImage));
+    out.write(reinterpret_cast<const char*>(regions.data()), regions.size() * sizeof(AssetPackRegion));
+    for (size_t i = 0; i < m_entries.size(); ++i) {
+        // pad up to the aligned offset
+        static const char zeros[16] = {};
+        uint64_t pos = out.tellp();
+        out.write(zeros, images[i].offset - pos);
+        out.write(reinterpret_cast<const char*>(m_entries[i].pixels.data()), m_entries[i].pixels.size());
+    }
+    return bool(out);
+}
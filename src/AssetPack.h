@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+// Read only file mapped into memory (mmap / MapViewOfFile).
+// Falls back to reading the whole file when mapping isn't available
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& path);
+    void Close();
+    const unsigned char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool isOpen() const { return m_data != nullptr; }
+
+private:
+    const unsigned char* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_mapped = false;
+    std::vector<unsigned char> m_fallback;
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#endif
+};
+
+
+// On disk layout of sprites.pack (all little endian, fixed size structs):
+//   AssetPackHeader
+//   AssetPackImage  x imageCount
+//   AssetPackRegion x regionCount
+//   raw RGBA8 pixels of every image, each block aligned to 16 bytes
+struct AssetPackHeader {
+    char magic[4];          // "AQPK"
+    uint32_t version;
+    uint32_t imageCount;
+    uint32_t regionCount;
+};
+
+struct AssetPackImage {
+    char name[48];          // atlas name, e.g. "creatures" or "title.png@1024x768"
+    uint32_t width;
+    uint32_t height;
+    uint32_t firstRegion;
+    uint32_t regionCount;
+    uint64_t offset;        // from the start of the file
+};
+
+struct AssetPackRegion {
+    float x, y, width, height;
+};
+
+static_assert(sizeof(AssetPackHeader) == 16, "pack header layout changed");
+static_assert(sizeof(AssetPackImage) == 72, "pack image layout changed");
+static_assert(sizeof(AssetPackRegion) == 16, "pack region layout changed");
+
+const uint32_t kAssetPackVersion = 2; // 2: no more mirrored regions
+
+
+// Baked sprite pages, mapped straight from disk so textures upload from the mapped pages
+class AssetPack {
+public:
+    bool Open(const std::string& path);
+    const AssetPackImage* FindImage(const std::string& name) const;
+    const AssetPackRegion* GetRegions(const AssetPackImage& image) const;
+    const unsigned char* GetPixels(const AssetPackImage& image) const;
+
+private:
+    MappedFile m_file;
+    const AssetPackHeader* m_header = nullptr;
+    const AssetPackImage* m_images = nullptr;
+    const AssetPackRegion* m_regions = nullptr;
+};
+
+
+// Used by the --bake-assets build step to write sprites.pack
+class AssetPackWriter {
+public:
+    void AddImage(const std::string& name, int width, int height,
+                  const std::vector<AssetPackRegion>& regions, const unsigned char* rgba);
+    bool Write(const std::string& path) const;
+
+private:
+    struct Entry {
+        std::string name;
+        int width;
+        int height;
+        std::vector<AssetPackRegion> regions;
+        std::vector<unsigned char> pixels;
+    };
+    std::vector<Entry> m_entries;
+};
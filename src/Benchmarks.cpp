@@ -0,0 +1,196 @@
+#include "Benchmarks.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include "AllocationCounter.h"
+#include "Aquarium.h"
+#include "MoveKernels.h"
+#include "Random.h"
+
+
+namespace {
+
+// Synthetic level: population split evenly across the species, no power ups
+class BenchLevel : public AquariumLevel {
+public:
+    BenchLevel(int levelNumber, int population, int targetScore)
+    : AquariumLevel(levelNumber, targetScore, INT_MAX / 4) {
+        for (int t = 0; t < kAquariumCreatureTypeCount; ++t) {
+            int count = population / kAquariumCreatureTypeCount + (t < population % kAquariumCreatureTypeCount ? 1 : 0);
+            this->addPopulation(AquariumCreatureType(t), count);
+        }
+    }
+};
+
+// 12 is Level_0 itself, bigger populations are synthetic
+std::shared_ptr<AquariumLevel> MakeLevel(int levelNumber, size_t population, int targetScore) {
+    if (population == 12) {
+        return std::make_shared<Level_0>(levelNumber, targetScore, INT_MAX / 4);
+    }
+    return std::make_shared<BenchLevel>(levelNumber, int(population), targetScore);
+}
+
+struct Fixture {
+    std::shared_ptr<AquariumSpriteManager> sprites;
+    std::shared_ptr<Aquarium> aquarium;
+    std::shared_ptr<PlayerCreature> player;
+};
+
+// aquarium filled to population, targetScore 0 makes every Repopulate() a level transition
+Fixture MakeFixture(size_t population, int targetScore = INT_MAX / 4, int levels = 1) {
+    Fixture f;
+    f.sprites = std::make_shared<AquariumSpriteManager>(false);
+    f.aquarium = std::make_shared<Aquarium>(1024, 768, f.sprites);
+    for (int i = 0; i < levels; ++i) {
+        f.aquarium->addAquariumLevel(MakeLevel(i, population, targetScore));
+    }
+    f.aquarium->Repopulate();
+    f.aquarium->getEvents().Clear();
+    f.player = std::make_shared<PlayerCreature>(462, 334, 5, f.sprites->GetSprite(AquariumCreatureType::NPCreature));
+    f.player->setBounds(1004, 748);
+    return f;
+}
+
+struct Result {
+    std::string name;
+    size_t population;
+    size_t iterations;
+    double meanNs;
+    double minNs;
+    double medianNs;
+    double allocationsPerIteration;
+};
+
+// Times every iteration on its own; between() runs untimed after each one (refills, resets).
+// Runs for about 200 ms after a warm up iteration, at least 5 and at most 10000 iterations
+Result Measure(const std::string& name, size_t population, const std::function<void()>& body,
+               const std::function<void()>& between = nullptr) {
+    using Clock = std::chrono::steady_clock;
+    body();
+    if (between) between();
+
+    std::vector<double> samples;
+    samples.reserve(10000);
+    uint64_t allocations = 0;
+    double total = 0;
+    while (samples.size() < 10000 && (samples.size() < 5 || total < 2e8)) {
+        uint64_t allocationsBefore = GetAllocationCount();
+        auto begin = Clock::now();
+        body();
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+        allocations += GetAllocationCount() - allocationsBefore;
+        samples.push_back(ns);
+        total += ns;
+        if (between) between();
+    }
+
+    Result result;
+    result.name = name;
+    result.population = population;
+    result.iterations = samples.size();
+    result.meanNs = total / samples.size();
+    result.minNs = *std::min_element(samples.begin(), samples.end());
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    result.medianNs = samples[samples.size() / 2];
+    result.allocationsPerIteration = double(allocations) / result.iterations;
+    ofLogNotice() << name << " @ " << population << ": " << result.medianNs / 1000.0 << " us median, "
+                  << result.allocationsPerIteration << " allocations/iteration";
+    return result;
+}
+
+} // namespace
+
+
+bool RunBenchmarks(const std::string& outputPath, size_t maxPopulation) {
+    ofSetLogLevel(OF_LOG_NOTICE);
+    std::vector<Result> results;
+    const float tick = 1.0f / 60.0f;
+
+    for (size_t population : {size_t(12), size_t(100), size_t(1000), size_t(10000), size_t(100000), size_t(1000000)}) {
+        if (population > maxPopulation) break;
+
+        {
+            Fixture f = MakeFixture(population);
+            results.push_back(Measure("Aquarium::update", population, [&] {
+                f.aquarium->update(tick);
+            }, [&] { f.aquarium->getEvents().Clear(); }));
+        }
+        {
+            Fixture f = MakeFixture(population);
+            results.push_back(Measure("DetectAquariumCollisions", population, [&] {
+                DetectAquariumCollisions(f.aquarium, f.player);
+            }, [&] { f.aquarium->getEvents().Clear(); }));
+        }
+        {
+            // the power up sits away from the player, this is the per tick miss
+            Fixture f = MakeFixture(population);
+            f.aquarium->SpawnPowerUp(PowerUpType::Health);
+            f.player->setPosition(-15, -20);
+            results.push_back(Measure("DetectPowerUpCollisions", population, [&] {
+                DetectPowerUpCollisions(f.aquarium, f.player);
+            }, [&] { f.aquarium->getEvents().Clear(); }));
+        }
+        {
+            // both levels complete right away, every call clears the aquarium and spawns the next level
+            Fixture f = MakeFixture(population, 0, 2);
+            results.push_back(Measure("Aquarium::Repopulate (level transition)", population, [&] {
+                f.aquarium->Repopulate();
+            }, [&] { f.aquarium->getEvents().Clear(); }));
+        }
+        {
+            Fixture f = MakeFixture(population);
+            results.push_back(Measure("Aquarium::SpawnCreature", population, [&] {
+                f.aquarium->SpawnCreature(AquariumCreatureType::NPCreature);
+            }, [&] { f.aquarium->getEvents().Clear(); }));
+        }
+        {
+            // a random row goes, and a spawn puts the population back
+            Fixture f = MakeFixture(population);
+            Random picks(1, RandomStream::Spawn);
+            results.push_back(Measure("Aquarium::removeCreature", population, [&] {
+                const CreatureStore& store = f.aquarium->getCreatureStore();
+                f.aquarium->removeCreature(store.getHandle(picks.Below(store.size())));
+            }, [&] {
+                f.aquarium->SpawnCreature(AquariumCreatureType::NPCreature);
+                f.aquarium->getEvents().Clear();
+            }));
+        }
+        {
+            std::shared_ptr<AquariumLevel> level = MakeLevel(0, population, INT_MAX / 4);
+            int toSpawn[kAquariumCreatureTypeCount];
+            level->Repopulate(toSpawn);
+            results.push_back(Measure("AquariumLevel::ConsumePopulation", population, [&] {
+                level->ConsumePopulation(AquariumCreatureType::NewNemoCreature, 1);
+            }, [&] { level->Repopulate(toSpawn); }));
+        }
+    }
+
+    std::ostringstream json;
+    json << "{\n  \"kernel\": \"" << SelectMoveKernel().name << "\",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        json << "    {\"name\": \"" << r.name << "\", \"population\": " << r.population
+             << ", \"iterations\": " << r.iterations << ", \"mean_ns\": " << r.meanNs
+             << ", \"median_ns\": " << r.medianNs << ", \"min_ns\": " << r.minNs
+             << ", \"allocations_per_iteration\": " << r.allocationsPerIteration << "}"
+             << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    json << "  ]\n}\n";
+
+    if (outputPath.empty()) {
+        std::cout << json.str();
+        return true;
+    }
+    std::ofstream file(outputPath);
+    file << json.str();
+    if (!file) {
+        ofLogError() << "Failed to write benchmark results to " << outputPath;
+        return false;
+    }
+    ofLogNotice() << "Benchmark results written to " << outputPath;
+    return true;
+}
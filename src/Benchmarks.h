@@ -0,0 +1,10 @@
+#pragma once
+
+#include <string>
+
+
+// Microbenchmarks of the per tick hot paths (update, collisions, repopulation, spawn/remove, population
+// bookkeeping) at populations from Level_0's 12 fish up to maxPopulation synthetic fish.
+// Writes JSON with the time and heap allocations per iteration to outputPath (stdout when empty).
+// Used by --bench
+bool RunBenchmarks(const std::string& outputPath, size_t maxPopulation = 1000000);
@@ -0,0 +1,65 @@
+#include "Compositor.h"
+#include "Core.h"
+
+
+void Compositor::SetLayer(CompositorLayer which, int x, int y, int width, int height, Painter paint, ContentKey key, bool opaque) {
+    Layer& layer = m_layers[int(which)];
+    layer.paint = std::move(paint);
+    layer.key = std::move(key);
+    layer.x = x;
+    layer.y = y;
+    layer.opaque = opaque;
+    layer.dirty = true;
+    if (layer.key && (!layer.fbo.isAllocated() || layer.width != width || layer.height != height)) {
+        layer.fbo.allocate(std::max(width, 1), std::max(height, 1), GL_RGBA);
+    }
+    layer.width = width;
+    layer.height = height;
+}
+
+void Compositor::InvalidateAll() {
+    for (Layer& layer : m_layers) {
+        layer.dirty = true;
+    }
+}
+
+void Compositor::Repaint(Layer& layer) {
+    layer.fbo.begin();
+    if (layer.opaque) {
+        ofClear(ofGetBackgroundColor()); // nothing under it shows through, even where the painter leaves gaps
+    } else {
+        ofClear(0, 0, 0, 0);
+    }
+    ofPushMatrix();
+    ofTranslate(-layer.x, -layer.y);
+    layer.paint();
+    ofPopMatrix();
+    layer.fbo.end();
+    ++m_repaints;
+}
+
+void Compositor::Draw() {
+    m_repaints = 0;
+    for (Layer& layer : m_layers) {
+        if (!layer.paint) continue;
+        if (!layer.key) {
+            layer.paint();
+            continue;
+        }
+        uint64_t key = layer.key();
+        if (layer.dirty || key != layer.lastKey) {
+            layer.lastKey = key;
+            layer.dirty = false;
+            this->Repaint(layer);
+        }
+        ofSetColor(ofColor::white);
+        if (layer.opaque) {
+            ofDisableAlphaBlending(); // a plain copy, no blending against what's under it
+            layer.fbo.draw(layer.x, layer.y);
+            ofEnableAlphaBlending();
+        } else {
+            layer.fbo.draw(layer.x, layer.y);
+        }
+        RenderStats::CountDrawCall();
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include "ofMain.h"
+
+
+// Layers of a frame, drawn in this order
+enum class CompositorLayer : uint8_t {
+    Background, // full window, opaque: the aquarium background or a scene's own (title, game over)
+    Creatures,  // the simulation, changes every frame
+    Hud,        // score panel
+    Overlay,    // help/pause texts and the key hints
+    Count
+};
+
+// Draws the frame as a stack of layers. A cached layer is painted into its own FBO, sized to the part of the
+// window it covers, and only painted again when its content key changes (or after Resize/Invalidate); every
+// other frame it's a single blit. An opaque full window layer replaces the clear, so an unchanged frame costs
+// one opaque copy plus the small HUD/overlay rectangles on top of whatever is dynamic
+class Compositor {
+public:
+    using Painter = std::function<void()>;    // draws in window coordinates
+    using ContentKey = std::function<uint64_t()>;
+
+    // cached layers need a key, dynamic ones (no key) are painted straight to the screen every frame
+    void SetLayer(CompositorLayer layer, int x, int y, int width, int height, Painter paint, ContentKey key = nullptr, bool opaque = false);
+    void Invalidate(CompositorLayer layer) { m_layers[int(layer)].dirty = true; }
+    void InvalidateAll();
+    void Draw();
+    int getLastRepaints() const { return m_repaints; } // cached layers painted again in the last Draw
+
+private:
+    struct Layer {
+        Painter paint;
+        ContentKey key;
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+        bool opaque = false;
+        bool dirty = true;
+        uint64_t lastKey = 0;
+        ofFbo fbo;
+    };
+    void Repaint(Layer& layer);
+    Layer m_layers[int(CompositorLayer::Count)];
+    int m_repaints = 0;
+};
@@ -1,92 +1,224 @@
 #include "Core.h"
+#include "AssetLoader.h"
 
 
-// Sets bounds: inherited powerup subclasses
-void PowerUp::setBounds(int w, int h) { m_width = w; m_height = h; }
+// SpriteAtlas
+int SpriteAtlas::Add(const std::string& imagePath, int width, int height) {
+    m_sources.push_back(imagePath);
+    return this->Place(width, height);
+}
 
-// Creature Inherited Base Behavior
-void Creature::setBounds(int w, int h) { m_width = w; m_height = h; }
+// simple shelf packing, 2px of padding so linear filtering doesn't bleed between regions
+int SpriteAtlas::Place(int width, int height) {
+    const int padding = 2;
+    if (m_penX > 0 && m_penX + width > m_maxWidth) {
+        m_penX = 0;
+        m_penY += m_shelfHeight + padding;
+        m_shelfHeight = 0;
+    }
+    m_regions.emplace_back(m_penX, m_penY, width, height);
+    m_penX += width + padding;
+    m_shelfHeight = std::max(m_shelfHeight, height);
+    m_pageWidth = std::max(m_pageWidth, m_penX - padding);
+    m_pageHeight = std::max(m_pageHeight, m_penY + height);
+    return m_regions.size() - 1;
+}
 
+// the png path: decode and resize every source on the cpu
+ofPixels SpriteAtlas::Compose() const {
+    ofPixels page;
+    page.allocate(m_pageWidth, m_pageHeight, OF_IMAGE_COLOR_ALPHA);
+    std::fill(page.getData(), page.getData() + page.size(), 0);
+    for (size_t i = 0; i < m_sources.size(); ++i) {
+        const ofRectangle& r = m_regions[i];
+        ofPixels decoded;
+        if (!ofLoadImage(decoded, m_sources[i])) {
+            std::cerr << "Failed to load image: " << m_sources[i] << std::endl;
+            decoded.allocate(r.width, r.height, OF_IMAGE_COLOR_ALPHA);
+        }
+        decoded.setImageType(OF_IMAGE_COLOR_ALPHA); // every region must share the atlas format
+        decoded.resize(r.width, r.height);
+        decoded.pasteInto(page, r.x, r.y);
+    }
+    return page;
+}
 
-void Creature::normalize() {
-    float length = std::sqrt(m_dx * m_dx + m_dy * m_dy);
-    if (length != 0) {
-        m_dx /= length;
-        m_dy /= length;
+// baked page is only used if it was baked from the same layout
+const AssetPackImage* SpriteAtlas::FindInPack() const {
+    if (!s_pack) return nullptr;
+    const AssetPackImage* image = s_pack->FindImage(m_name);
+    if (image == nullptr || int(image->width) != m_pageWidth || int(image->height) != m_pageHeight
+        || int(image->regionCount) != this->getRegionCount()) {
+        return nullptr;
     }
+    const AssetPackRegion* regions = s_pack->GetRegions(*image);
+    for (int i = 0; i < this->getRegionCount(); ++i) {
+        if (regions[i].x != m_regions[i].x || regions[i].y != m_regions[i].y
+            || regions[i].width != m_regions[i].width || regions[i].height != m_regions[i].height) {
+            return nullptr;
+        }
+    }
+    return image;
 }
 
-void Creature::bounce() {
-    // should implement boundary controls here
+// cpu side only, safe to run on a loader thread
+void SpriteAtlas::Decode() {
+    if (this->FindInPack() != nullptr) return; // nothing to decode, Upload reads the mapped pack
+    if (s_pack) {
+        ofLogNotice() << "Atlas " << m_name << " not in the asset pack, decoding pngs" << std::endl;
+    }
+    m_staged = this->Compose();
+}
 
-    // -15, -20, -30, and -35 are used as offsets to better match the screen size
-    if(m_x < -15)
-    {
-        m_x = -15;
-        // m_speed != 5 is checked to differentiate the player from most NPCs
-        //      as the player has a default speed of 5 but most NPCs don't, and
-        //      they should not behave in the same manner
-        if (m_speed != 5)
-            m_dx *= -1;
-    }
-    if(m_x > m_width-35)
-    {
-        m_x = m_width-35;
-        if (m_speed != 5)
-            m_dx *= -1;
+// gl side, main thread only
+void SpriteAtlas::Upload() {
+    const AssetPackImage* image = this->FindInPack();
+    if (image != nullptr) {
+        m_texture.allocate(image->width, image->height, GL_RGBA);
+        m_texture.loadData(s_pack->GetPixels(*image), image->width, image->height, GL_RGBA);
+    } else {
+        if (!m_staged.isAllocated()) m_staged = this->Compose();
+        m_texture.loadData(m_staged); // one upload for the whole set
     }
-    if(m_y < -20)
-    {
-        m_y = -20;
-        if (m_speed != 5)
-            m_dy *= -1;
+    m_staged.clear(); // the texture is all we keep, no cpu copy of the pixels
+}
+
+void SpriteAtlas::Build() {
+    this->Decode();
+    this->Upload();
+}
+
+void SpriteAtlas::Bake(AssetPackWriter& writer) const {
+    ofPixels page = this->Compose();
+    std::vector<AssetPackRegion> regions;
+    for (const ofRectangle& r : m_regions) {
+        regions.push_back({r.x, r.y, r.width, r.height});
     }
-    if(m_y > m_height-30)
-    {
-        m_y = m_height-30;
-        if (m_speed != 5)
-            m_dy *= -1;
+    writer.AddImage(m_name, m_pageWidth, m_pageHeight, regions, page.getData());
+}
+
+// SpriteBatch
+void SpriteBatch::Add(const GameSprite& sprite, float x, float y, bool flipped, const ofColor& tint) {
+    if (sprite.getAtlas() != m_atlas) {
+        this->Flush(); // new page, previous quads have to go out first
+        m_atlas = sprite.getAtlas();
+    }
+    const ofTexture& texture = m_atlas->getTexture();
+    const ofRectangle& r = sprite.getRegion();
+    float u0 = r.x / texture.getWidth();
+    float v0 = r.y / texture.getHeight();
+    float u1 = (r.x + r.width) / texture.getWidth();
+    float v1 = (r.y + r.height) / texture.getHeight();
+    if (flipped) {
+        std::swap(u0, u1); // mirror horizontally
+    }
+
+    unsigned int base = m_mesh.getNumVertices();
+    m_mesh.addVertex(glm::vec3(x, y, 0));
+    m_mesh.addVertex(glm::vec3(x + r.width, y, 0));
+    m_mesh.addVertex(glm::vec3(x + r.width, y + r.height, 0));
+    m_mesh.addVertex(glm::vec3(x, y + r.height, 0));
+    // getCoordFromPercent takes care of ARB (pixel) vs normalized texture coordinates
+    m_mesh.addTexCoord(texture.getCoordFromPercent(u0, v0));
+    m_mesh.addTexCoord(texture.getCoordFromPercent(u1, v0));
+    m_mesh.addTexCoord(texture.getCoordFromPercent(u1, v1));
+    m_mesh.addTexCoord(texture.getCoordFromPercent(u0, v1));
+    for (int i = 0; i < 4; ++i) {
+        m_mesh.addColor(tint);
     }
+    m_mesh.addIndex(base);     m_mesh.addIndex(base + 1); m_mesh.addIndex(base + 2);
+    m_mesh.addIndex(base);     m_mesh.addIndex(base + 2); m_mesh.addIndex(base + 3);
+}
+
+void SpriteBatch::Flush() {
+    if (m_atlas != nullptr && m_mesh.getNumVertices() > 0) {
+        m_mesh.setMode(OF_PRIMITIVE_TRIANGLES);
+        m_atlas->getTexture().bind();
+        m_mesh.draw();
+        m_atlas->getTexture().unbind();
+        RenderStats::CountDrawCall();
+    }
+    m_mesh.clear(); // clear keeps the vector capacity
+    m_atlas = nullptr;
+}
+
+std::shared_ptr<SpriteAtlas> GameSprite::DescribeStandalone(const std::string& imagePath, int width, int height) {
+    auto atlas = std::make_shared<SpriteAtlas>(imagePath + "@" + std::to_string(width) + "x" + std::to_string(height), width);
+    atlas->Add(imagePath, width, height);
+    return atlas;
+}
+
+GameSprite::GameSprite(const std::string& imagePath, int width, int height) {
+    auto atlas = DescribeStandalone(imagePath, width, height);
+    m_region = 0;
+    atlas->Build();
+    m_atlas = atlas;
 }
 
 
+// Sets bounds: inherited powerup subclasses
+void PowerUp::setBounds(int w, int h) { m_width = w; m_height = h; }
+
+
+
 void GameEvent::print() const {
         
         switch (type) {
             case GameEventType::NONE:
-                ofLogVerbose() << "No event." << std::endl;
+                AQ_LOG_VERBOSE() << "No event." << std::endl;
                 break;
             case GameEventType::COLLISION:
-                ofLogVerbose() << "Collision event between creatures at (" 
-                << creatureA->getX() << ", " << creatureA->getY() << ") and ("
-                << creatureB->getX() << ", " << creatureB->getY() << ")." << std::endl;
+                AQ_LOG_VERBOSE() << "Collision event between the player and creature " << creature.slot
+                << " at (" << x << ", " << y << ")." << std::endl;
+                break;
+            case GameEventType::POWERUP:
+                AQ_LOG_VERBOSE() << "Power up " << powerUp << " picked up." << std::endl;
                 break;
             case GameEventType::CREATURE_ADDED:
-                ofLogVerbose() << "Creature added at (" 
-                << creatureA->getX() << ", " << creatureA->getY() << ")." << std::endl;
+                AQ_LOG_VERBOSE() << count << " creature(s) added, the first at ("
+                << x << ", " << y << ")." << std::endl;
                 break;
             case GameEventType::CREATURE_REMOVED:
-                ofLogVerbose() << "Creature removed at (" 
-                << creatureA->getX() << ", " << creatureA->getY() << ")." << std::endl;
+                AQ_LOG_VERBOSE() << "Creature removed at (" 
+                << x << ", " << y << ")." << std::endl;
                 break;
             case GameEventType::GAME_OVER:
-                ofLogVerbose() << "Game Over event." << std::endl;
+                AQ_LOG_VERBOSE() << "Game Over event." << std::endl;
                 break;
             case GameEventType::NEW_LEVEL:
-                ofLogVerbose() << "New Game level" << std::endl;
+                AQ_LOG_VERBOSE() << "New Game level, level " << level << " completed" << std::endl;
+                break;
             default:
-                ofLogVerbose() << "Unknown event type." << std::endl;
+                AQ_LOG_VERBOSE() << "Unknown event type." << std::endl;
                 break;
         }
 };
 
+bool GameEventQueue::Publish(const GameEvent& event) {
+    if (m_count == m_events.size()) {
+        ++m_dropped;
+        return false;
+    }
+    m_events[(m_head + m_count) % m_events.size()] = event;
+    ++m_count;
+    return true;
+}
+
+bool GameEventQueue::Poll(GameEvent& event) {
+    if (m_count == 0) return false;
+    event = m_events[m_head];
+    m_head = (m_head + 1) % m_events.size();
+    --m_count;
+    return true;
+}
+
 // collision detection between two creatures
+// closer than the larger of the two radii, compared squared so there's no sqrt
 bool checkCollision(std::shared_ptr<Creature> a, std::shared_ptr<Creature> b) {
-    double distance = sqrt(pow(a->getX()-b->getX(),2.0) + pow(a->getY()-b->getY(),2.0));
-    if(distance < a->getCollisionRadius() || distance < b->getCollisionRadius())
-        return true;
-        
-    return false; 
+    float dx = a->getX() - b->getX();
+    float dy = a->getY() - b->getY();
+    float reach = std::max(a->getCollisionRadius(), b->getCollisionRadius());
+    return dx * dx + dy * dy < reach * reach;
 };
 
 
@@ -97,57 +229,100 @@ string GameSceneKindToString(GameSceneKind t){
         case GameSceneKind::GAME_INTRO: return "GAME_INTRO";
         case GameSceneKind::AQUARIUM_GAME: return "AQUARIUM_GAME";
         case GameSceneKind::GAME_OVER: return "GAME_OVER";
+        case GameSceneKind::PAUSE: return "PAUSE";
+        case GameSceneKind::HELP: return "HELP";
+        default: return "UNKNOWN";
     };
 };
 
-std::shared_ptr<GameScene> GameSceneManager::GetScene(string name){
-    if(!this->HasScenes()){return nullptr;}
-    for(std::shared_ptr<GameScene> scene : this->m_scenes){
-        if(scene->GetName() == name){
-            return scene;
-        }
+void GameSceneManager::AddScene(GameSceneKind kind, std::shared_ptr<GameScene> newScene){
+    if(newScene == nullptr || this->m_scenes[int(kind)] != nullptr){
+        return; // this scene already exist and shouldn't be added again
+    }
+    this->m_scenes[int(kind)] = std::move(newScene);
+    if(!this->HasScenes()){
+        this->m_stack[0] = kind; // need to place in active scene as its the only one in existance right now
+        this->m_depth = 1;
     }
-    return nullptr;
 }
 
-void GameSceneManager::Transition(string name){
-    if(!this->HasScenes()){return;} // no need to do anything if nothing inside
-    std::shared_ptr<GameScene> newScene = this->GetScene(name);
-    if(newScene == nullptr){return;} // i dont have the scene so time to leave
-    if(newScene->GetName() == this->m_active_scene->GetName()){return;} // another do nothing since active scene is already pulled
-    this->m_active_scene = newScene; // now we keep it since this is a valid transition
-    return;
+void GameSceneManager::Preload(GameSceneKind kind){
+    GameScene* scene = this->GetScene(kind);
+    if(scene == nullptr || this->m_preloaded[int(kind)]){return;}
+    this->m_preloaded[int(kind)] = true;
+    scene->Preload();
 }
 
-void GameSceneManager::AddScene(std::shared_ptr<GameScene> newScene){
-    if(this->GetScene(newScene->GetName()) != nullptr){
-        return; // this scene already exist and shouldn't be added again
-    }
-    this->m_scenes.push_back(newScene);
-    if(m_active_scene == nullptr){
-        this->m_active_scene = newScene; // need to place in active scene as its the only one in existance right now
+void GameSceneManager::Transition(GameSceneKind kind){
+    if(this->GetScene(kind) == nullptr){return;} // i dont have the scene so time to leave
+    this->Preload(kind);
+    this->m_stack[0] = kind;
+    this->m_depth = 1;
+}
+
+bool GameSceneManager::PushOverlay(GameSceneKind kind){
+    if(!this->HasScenes() || this->GetScene(kind) == nullptr || this->HasOverlay(kind) || this->m_depth == this->m_stack.size()){
+        return false;
     }
-    return;
+    this->Preload(kind);
+    this->m_stack[this->m_depth++] = kind;
+    return true;
 }
 
-std::shared_ptr<GameScene> GameSceneManager::GetActiveScene(){
-    return this->m_active_scene;
+// from wherever it is in the stack, the ones above it move down
+void GameSceneManager::RemoveOverlay(GameSceneKind kind){
+    for(size_t i = 1; i < this->m_depth; ++i){
+        if(this->m_stack[i] == kind){
+            std::copy(this->m_stack.begin() + i + 1, this->m_stack.begin() + this->m_depth, this->m_stack.begin() + i);
+            --this->m_depth;
+            return;
+        }
+    }
 }
 
-string GameSceneManager::GetActiveSceneName(){
-    if(this->m_active_scene == nullptr){return "";} // something to handle missing activate scenes
-    return this->m_active_scene->GetName();
+bool GameSceneManager::HasOverlay(GameSceneKind kind) const {
+    for(size_t i = 1; i < this->m_depth; ++i){
+        if(this->m_stack[i] == kind){return true;}
+    }
+    return false;
 }
 
 void GameSceneManager::UpdateActiveScene(){
-    if(!this->HasScenes()){return;} // make sure we have a scene before we try to paint
-    this->m_active_scene->Update();
-
+    for(size_t i = this->m_depth; i > 0; --i){
+        GameScene* scene = this->GetScene(this->m_stack[i - 1]);
+        scene->Update();
+        if(scene->BlocksUpdateBelow()){return;}
+    }
 }
 
 void GameSceneManager::DrawActiveScene(){
-    if(!this->HasScenes()){return;} // make sure we have something before Drawing it
-    this->m_active_scene->Draw();
+    if(!this->HasScenes()){return;}
+    this->GetActiveScene()->Draw();
+}
+
+void GameSceneManager::DrawOverlays(){
+    for(size_t i = 1; i < this->m_depth; ++i){
+        this->GetScene(this->m_stack[i])->Draw();
+    }
+}
+
+uint64_t GameSceneManager::GetStackKey() const {
+    uint64_t key = this->m_depth;
+    for(size_t i = 0; i < this->m_depth; ++i){
+        key = key << 8 | uint64_t(this->m_stack[i]);
+    }
+    return key;
+}
+
+void PauseOverlayScene::Draw(){
+    this->m_noHelp.Draw(this->m_font);
+    this->m_unpause.Draw(this->m_font);
+    this->m_breathe.Draw(this->m_font);
+}
+
+void HelpOverlayScene::Draw(){
+    this->m_arrows.Draw(this->m_font);
+    this->m_powerUps.Draw(this->m_font);
 }
 
 
@@ -155,16 +330,51 @@ void GameIntroScene::Update(){
 
 }
 
-void GameIntroScene::Draw(){
+void GameIntroScene::DrawBackground(){
     this->m_banner->draw(0,0);
 }
 
+void GameIntroScene::Draw(){
+    // loading bar along the bottom until the game assets are in
+    if(!this->IsReady()){
+        float barWidth = ofGetWindowWidth() * 0.5f;
+        float x = (ofGetWindowWidth() - barWidth) / 2;
+        float y = ofGetWindowHeight() - 40;
+        ofSetColor(ofColor::black);
+        ofDrawRectangle(x, y, barWidth, 10);
+        ofSetColor(ofColor::white);
+        ofDrawRectangle(x, y, barWidth * this->GetProgress(), 10);
+        ofDrawBitmapString("Loading... " + std::to_string(int(this->GetProgress() * 100)) + "%", x, y - 8);
+    }
+}
+
+void GameIntroScene::SetLoader(std::shared_ptr<const AssetLoader> loader, std::vector<string> requiredAssets){
+    this->m_loader = std::move(loader);
+    this->m_requiredAssets = std::move(requiredAssets);
+}
+
+float GameIntroScene::GetProgress() const {
+    if(this->m_loader == nullptr){return 1.0f;}
+    return this->m_loader->GetProgress();
+}
+
+bool GameIntroScene::IsReady() const {
+    if(this->m_loader == nullptr){return true;}
+    for(const string& asset : this->m_requiredAssets){
+        if(!this->m_loader->IsResident(asset)){return false;}
+    }
+    return true;
+}
+
 void GameOverScene::Update(){
 
 }
 
 void GameOverScene::Draw(){
+
+}
+
+void GameOverScene::DrawBackground(){
     ofBackgroundGradient(ofColor::red, ofColor::black);
     this->m_banner->draw(0,0);
-
 }
\ No newline at end of file
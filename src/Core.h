@@ -1,9 +1,16 @@
+#pragma once
+
 #include <iostream>
+#include <array>
 #include <memory>
 #include <utility>
 #include <cmath>
 #include <algorithm>
 #include "ofMain.h"
+#include "Log.h"
+#include "Hud.h"
+#include "AssetPack.h"
+#include "CreatureStore.h"
 
 
 class AwaitFrames {
@@ -22,59 +29,155 @@ private:
 	int m_counter;
 };
 
-class GameSprite {
+// Real clock accumulator for a fixed simulation rate, independent of the frame rate.
+// Advance() takes the frame's real time and returns how many ticks to run, getAlpha() is how far
+// into the next tick the frame is, for interpolating what gets drawn
+class FixedTimestep {
 public:
-    GameSprite(const std::string& imagePath, int width, int height) {
-        if (!m_image.load(imagePath)) {
-            std::cerr << "Failed to load image: " << imagePath << std::endl;
-        }
-        m_image.resize(width, height);
-        m_flippedImage = m_image;
-        m_flippedImage.mirror(false, true); // Mirror horizontally
-    }
+	explicit FixedTimestep(double ticksPerSecond = 60.0) { setTickRate(ticksPerSecond); }
+	void setTickRate(double ticksPerSecond) { m_step = 1.0 / std::max(1.0, ticksPerSecond); }
+	double getTickRate() const { return 1.0 / m_step; }
+	double getStep() const { return m_step; }
+	int Advance(double seconds) {
+		// a long stall (window drag, breakpoint) shouldn't turn into a burst of catch up ticks
+		m_accumulator += std::min(seconds, 0.25);
+		int ticks = 0;
+		while (m_accumulator >= m_step) {
+			m_accumulator -= m_step;
+			++ticks;
+		}
+		return ticks;
+	}
+	float getAlpha() const { return float(m_accumulator / m_step); }
+	void Reset() { m_accumulator = 0; }
+private:
+	double m_step;
+	double m_accumulator = 0;
+};
 
-    void draw(float x, float y) const {
-        if (m_flipped) {
-            m_flippedImage.draw(x, y);
+// Per frame draw call counter, so we can check batching keeps it O(types) and not O(creatures)
+class RenderStats {
+public:
+    static void NewFrame() { s_lastFrameDrawCalls = s_drawCalls; s_drawCalls = 0; }
+    static void CountDrawCall() { ++s_drawCalls; }
+    static int GetLastFrameDrawCalls() { return s_lastFrameDrawCalls; }
+private:
+    static inline int s_drawCalls = 0;
+    static inline int s_lastFrameDrawCalls = 0;
+};
+
+// One texture that holds every sprite of an asset set, packed in shelves.
+// Regions are handed out while adding images, the decoding and the single upload happen in Build().
+// If a baked asset pack is in use and it has this atlas, Build() uploads straight from the mapped pack instead
+class SpriteAtlas {
+public:
+    SpriteAtlas(const std::string& name, int maxWidth = 1024) : m_name(name), m_maxWidth(maxWidth) {}
+
+    // Queues an image resized to width x height, returns its region index.
+    // There are no mirrored copies, sprites flip at draw time by mirroring the texture coordinates
+    int Add(const std::string& imagePath, int width, int height);
+    void Build();
+    // Build() split in two so the decoding can run on a loader thread (see AssetLoader)
+    void Decode();
+    void Upload();
+    bool isResident() const { return m_texture.isAllocated(); }
+    // Decodes every queued image and writes the finished page into the pack (--bake-assets)
+    void Bake(AssetPackWriter& writer) const;
+
+    const std::string& getName() const { return m_name; }
+    const ofTexture& getTexture() const { return m_texture; }
+    const ofRectangle& getRegion(int region) const { return m_regions.at(region); }
+    int getRegionCount() const { return m_regions.size(); }
+    size_t getTextureBytes() const { return size_t(m_texture.getWidth()) * size_t(m_texture.getHeight()) * 4; }
+    size_t getCpuBytes() const { return m_staged.size(); } // zero once uploaded
+
+    // Pack shared by every atlas, set once at startup
+    static void UsePack(std::shared_ptr<const AssetPack> pack) { s_pack = std::move(pack); }
+
+private:
+    int Place(int width, int height);
+    const AssetPackImage* FindInPack() const;
+    ofPixels Compose() const;
+
+    std::string m_name;
+    int m_maxWidth;
+    int m_penX = 0;
+    int m_penY = 0;
+    int m_shelfHeight = 0;
+    int m_pageWidth = 0;
+    int m_pageHeight = 0;
+    std::vector<std::string> m_sources;
+    std::vector<ofRectangle> m_regions;
+    ofPixels m_staged; // decoded page waiting for Upload()
+    ofTexture m_texture;
+
+    static inline std::shared_ptr<const AssetPack> s_pack;
+};
+
+// Lightweight sprite instance: just points at a region of a shared atlas.
+// Orientation belongs to whoever draws it (the creature), not to the sprite
+class GameSprite {
+public:
+    GameSprite(std::shared_ptr<const SpriteAtlas> atlas, int region)
+    : m_atlas(std::move(atlas)), m_region(region) {}
+
+    // Standalone sprite (banners, backgrounds), gets an atlas of its own
+    GameSprite(const std::string& imagePath, int width, int height);
+    // The atlas a standalone sprite uses, before it is built. The bake step uses it too
+    static std::shared_ptr<SpriteAtlas> DescribeStandalone(const std::string& imagePath, int width, int height);
+
+    // flipped mirrors the texture coordinates horizontally
+    void draw(float x, float y, bool flipped = false) const {
+        if (!this->isResident()) return; // still being loaded
+        const ofRectangle& r = this->getRegion();
+        if (flipped) {
+            m_atlas->getTexture().drawSubsection(x, y, r.width, r.height, r.x + r.width, r.y, -r.width, r.height);
         } else {
-            m_image.draw(x, y);
+            m_atlas->getTexture().drawSubsection(x, y, r.width, r.height, r.x, r.y, r.width, r.height);
         }
+        RenderStats::CountDrawCall();
     }
 
-    void setFlipped(bool flipped) { m_flipped = flipped; }
+    bool isResident() const { return m_atlas->isResident(); }
+    const SpriteAtlas* getAtlas() const { return m_atlas.get(); }
+    const ofRectangle& getRegion() const { return m_atlas->getRegion(m_region); }
 
 private:
-    ofImage m_image;
-    ofImage m_flippedImage;
-    bool m_flipped = false;
+    std::shared_ptr<const SpriteAtlas> m_atlas;
+    int m_region = 0;
 };
 
+// Collects textured quads and submits all quads sharing an atlas page as one mesh draw
+class SpriteBatch {
+public:
+    void Add(const GameSprite& sprite, float x, float y, bool flipped = false, const ofColor& tint = ofColor::white);
+    void Flush();
+    int getQuadCount() const { return m_mesh.getNumVertices() / 4; }
+private:
+    const SpriteAtlas* m_atlas = nullptr;
+    ofMesh m_mesh; // kept around between frames so its buffers are reused
+};
 
-
+// A creature is a view over one row of a CreatureStore.
+// Creatures built on their own (the player, or an NPC made outside an aquarium) own a one row store,
+// views built over an existing store (NPCreature's store/row constructor) point into it
 class Creature {
 protected:
     Creature(float x, float y, int speed, float collisionRadius, int value,
              std::shared_ptr<GameSprite> sprite)
-    : m_x(x)
-    , m_y(y)
-    , m_dx(0)
-    , m_dy(0)
-    , m_speed(speed)
-    , m_width(0)
-    , m_height(0)
-    , m_collisionRadius(collisionRadius)
-    , m_value(value)
+    : m_store(std::make_shared<CreatureStore>())
+    , m_row(0)
+    , m_sprite(std::move(sprite)) {
+        m_store->Add(AquariumCreatureType::NPCreature, x, y, speed, collisionRadius, value);
+    }
+
+    Creature(std::shared_ptr<CreatureStore> store, size_t row, std::shared_ptr<GameSprite> sprite)
+    : m_store(std::move(store))
+    , m_row(row)
     , m_sprite(std::move(sprite)) {}
 
-    float m_x = 0.0f;
-    float m_y = 0.0f;
-    float m_dx = 0.0f;
-    float m_dy = 0.0f;
-    int m_speed = 0;
-    float m_width = 0.0f;
-    float m_height = 0.0f;
-    float m_collisionRadius = 0.0f;
-    int m_value = 0;
+    std::shared_ptr<CreatureStore> m_store;
+    size_t m_row = 0;
     std::shared_ptr<GameSprite> m_sprite;
 
 public:
@@ -82,24 +185,30 @@ public:
     virtual void move() = 0;
     virtual void draw() const = 0;
 
-    virtual float getCollisionRadius() const { return m_collisionRadius; }
-    virtual void setCollisionRadius(float radius) { m_collisionRadius = radius; }
+    virtual float getCollisionRadius() const { return m_store->radius[m_row]; }
+    virtual void setCollisionRadius(float radius) { m_store->radius[m_row] = radius; }
 
-    float getX() const { return m_x; }
-    float getY() const { return m_y; }
-    int getSpeed() const { return m_speed; }
-    void setSpeed(int speed) { m_speed = speed; }
-    void setFlipped(bool flipped) {
-        if (m_sprite) {
-            m_sprite->setFlipped(flipped);
-        }
+    float getX() const { return m_store->x[m_row]; }
+    float getY() const { return m_store->y[m_row]; }
+    // teleports, the previous position moves too so nothing gets interpolated across the jump
+    void setPosition(float x, float y) {
+        m_store->x[m_row] = m_store->prevX[m_row] = x;
+        m_store->y[m_row] = m_store->prevY[m_row] = y;
     }
+    int getSpeed() const { return m_store->speed[m_row]; }
+    void setSpeed(int speed) { m_store->speed[m_row] = speed; }
+    void setFlipped(bool flipped) { m_store->flipped[m_row] = flipped; }
+    bool isFlipped() const { return m_store->flipped[m_row] != 0; }
     void setSprite(std::shared_ptr<GameSprite> sprite) { m_sprite = std::move(sprite); }
-    int getValue() const { return m_value; }
-
-    void setBounds(int w, int h);
-    void normalize();
-    void bounce();
+    const std::shared_ptr<GameSprite>& getSprite() const { return m_sprite; }
+    int getValue() const { return m_store->value[m_row]; }
+    const CreatureStore* getStore() const { return m_store.get(); }
+    size_t getRow() const { return m_row; }
+
+    // bounds belong to the store, for aquarium creatures that means the whole aquarium
+    void setBounds(int w, int h) { m_store->setBounds(w, h); }
+    void normalize() { m_store->Normalize(m_row); }
+    void bounce() { m_store->Bounce(m_row); }
 };
 
 // Added enum for all powerup types
@@ -131,9 +240,11 @@ protected:
 public:
     virtual ~PowerUp() = default;
     virtual void draw() const /*= 0*/;
+    const std::shared_ptr<GameSprite>& getSprite() const { return m_sprite; }
     void setBounds(int w, int h);
     float getX() {return this->m_x;}
     float getY() {return this->m_y;}
+    void setPosition(float x, float y) { m_x = x; m_y = y; }
     virtual float getCollisionRadius() {return this->m_collisionRadius;}
     virtual void setCollisionRadius(float radius) { m_collisionRadius = radius; }
     virtual PowerUpType getPowerUpType() { return this->m_power_upType; }
@@ -154,24 +265,25 @@ enum class GameEventType {
     NEW_LEVEL,
 };
 
+// Plain value with no owning pointers, publishing one is a copy into the queue's ring.
+// The player is implied, it's the only one that collides
 class GameEvent {
     public:
-    GameEventType type;
-    std::shared_ptr<Creature> creatureA;    // player
-    std::shared_ptr<Creature> creatureB; // For collision events; npc
-    GameEvent() : type(GameEventType::NONE), creatureA(nullptr), creatureB(nullptr) {}
-    GameEvent(GameEventType t, std::shared_ptr<Creature> a , std::shared_ptr<Creature> b){
-        type = t;
-        creatureA = a;
-        creatureB = b;
-    }
-    // Collision events with powerups
-    std::shared_ptr<PowerUp> powerUp;   
-    GameEvent(GameEventType t, std::shared_ptr<PowerUp> b, std::shared_ptr<Creature> a){
-        type = t;
-        creatureA = a;
-        powerUp = b;
-    }
+    GameEventType type = GameEventType::NONE;
+    CreatureHandle creature;  // COLLISION, CREATURE_ADDED, CREATURE_REMOVED. Resolve it through the aquarium's store
+    int powerUp = -1;         // POWERUP: index into the aquarium's power ups
+    int level = -1;           // NEW_LEVEL: number of the level that was just completed
+    // CREATURE_ADDED: size of the batch, its rows start at `creature`'s. Like the handle, the range only holds
+    // until the next remove moves rows around
+    int count = 1;
+    // copied from the creature when the event is published, still readable after its row is gone
+    AquariumCreatureType creatureType = AquariumCreatureType::NPCreature;
+    int value = 0;
+    float x = 0.0f;
+    float y = 0.0f;
+
+    GameEvent() = default;
+    explicit GameEvent(GameEventType t) : type(t) {}
 
     
     // Additional methods can be added here
@@ -181,12 +293,44 @@ class GameEvent {
     bool isCreatureRemovedEvent() const { return type == GameEventType::CREATURE_REMOVED; }
     bool isGameOver() const { return type == GameEventType::GAME_OVER; }
     bool isGameExit() const { return type == GameEventType::GAME_EXIT; }
+    bool isNewLevel() const { return type == GameEventType::NEW_LEVEL; }
     bool isNoneEvent() const { return type == GameEventType::NONE; }
     
     // i want a printable representation of the event, with the creature descriptions if available
     void print() const;
 };
 
+// Fixed capacity FIFO for the events of a tick. The ring is allocated once up front,
+// publishing and draining never touch the heap
+class GameEventQueue {
+public:
+    explicit GameEventQueue(size_t capacity = 1024) : m_events(capacity) {}
+    bool Publish(const GameEvent& event); // false if the ring is full, the event is dropped and counted
+    bool Poll(GameEvent& event);
+    // hands every queued event to handler in publish order, including the ones published while draining
+    template<class Handler>
+    size_t Drain(Handler&& handler) {
+        size_t handled = 0;
+        GameEvent event;
+        while (this->Poll(event)) {
+            handler(event);
+            ++handled;
+        }
+        return handled;
+    }
+    void Clear() { m_head = 0; m_count = 0; }
+    size_t size() const { return m_count; }
+    bool empty() const { return m_count == 0; }
+    size_t capacity() const { return m_events.size(); }
+    size_t getDropped() const { return m_dropped; }
+
+private:
+    std::vector<GameEvent> m_events;
+    size_t m_head = 0;
+    size_t m_count = 0;
+    size_t m_dropped = 0;
+};
+
 
 bool checkCollision(std::shared_ptr<Creature> a, std::shared_ptr<Creature> b);
 
@@ -213,6 +357,15 @@ class GameScene {
         virtual string GetName() = 0;
         virtual void Update() = 0;
         virtual void Draw() = 0;
+        // cached layers (see Compositor.h), painted again only when their content changes. DrawBackground covers
+        // the whole window and is only repainted when the scene becomes active, DrawHud whenever GetHudKey changes
+        virtual void DrawBackground() {}
+        virtual void DrawHud() {}
+        virtual uint64_t GetHudKey() const { return 0; }
+        // work that can happen before the scene is shown, GameSceneManager::Preload runs it once
+        virtual void Preload() {}
+        // stacked scenes: whether the scenes under this one stop updating while it's up
+        virtual bool BlocksUpdateBelow() const { return true; }
         virtual ~GameScene() = default;
 
 };
@@ -220,21 +373,35 @@ class GameScene {
 enum class GameSceneKind {
     GAME_INTRO,
     AQUARIUM_GAME,
-    GAME_OVER
+    GAME_OVER,
+    PAUSE,      // overlays, pushed on top of the game
+    HELP,
+    Count
 };
+const int kGameSceneKindCount = int(GameSceneKind::Count);
 
 string GameSceneKindToString(GameSceneKind t);
 
+class AssetLoader;
+
 class GameIntroScene : public GameScene {
     public:
         GameIntroScene(string name, std::shared_ptr<GameSprite> banner)
         : m_name(name), m_banner(std::move(banner)){};
         string GetName() override {return this->m_name;}
         void Update() override;
-        void Draw() override;
+        void Draw() override; // the loading bar
+        void DrawBackground() override;
+
+        // the intro stays up while the loader works, requiredAssets are what the game needs before it can start
+        void SetLoader(std::shared_ptr<const AssetLoader> loader, std::vector<string> requiredAssets);
+        float GetProgress() const;
+        bool IsReady() const;
     private:
         string m_name;
         std::shared_ptr<GameSprite> m_banner;
+        std::shared_ptr<const AssetLoader> m_loader;
+        std::vector<string> m_requiredAssets;
 };
 
 class GameOverScene : public GameScene {
@@ -244,27 +411,89 @@ class GameOverScene : public GameScene {
         string GetName() override {return this->m_name;}
         void Update() override;
         void Draw() override;
+        void DrawBackground() override; // gradient and banner, never change
     private:
         string m_name;
         std::shared_ptr<GameSprite> m_banner;
 };
 
 
+// Pause overlay: freezes the game under it. font is the HUD's, it has to outlive the scene
+class PauseOverlayScene : public GameScene {
+    public:
+        explicit PauseOverlayScene(const ofTrueTypeFont* font) : m_font(font) {}
+        string GetName() override {return GameSceneKindToString(GameSceneKind::PAUSE);}
+        void Update() override {}
+        void Draw() override;
+    private:
+        const ofTrueTypeFont* m_font;
+        //Since in pause state everything stops, no help is available to make things, more interesting....
+        HudText m_noHelp{"Help not available. No advantages here...", 5, 20};
+        HudText m_unpause{"Press P to unpause game!", 5, 52};
+        HudText m_breathe{"You can now breathe...", 5, 68};
+};
+
+// Help overlay: shown while H is held, the game keeps going under it
+class HelpOverlayScene : public GameScene {
+    public:
+        explicit HelpOverlayScene(const ofTrueTypeFont* font) : m_font(font) {}
+        string GetName() override {return GameSceneKindToString(GameSceneKind::HELP);}
+        void Update() override {}
+        void Draw() override;
+        bool BlocksUpdateBelow() const override { return false; }
+    private:
+        const ofTrueTypeFont* m_font;
+        HudText m_arrows{"Use the arrow keys to move your fish around!", 5, 20}; //Added instructions in overlay to improve user experience
+        HudText m_powerUps{"PowerUps might appear at some points...", 5, 36};
+};
+
+// The scene class registered under each kind, so GameSceneManager::Get hands back the right type
+class AquariumGameScene; // Aquarium.h
+template <GameSceneKind Kind> struct GameSceneOf;
+template <> struct GameSceneOf<GameSceneKind::GAME_INTRO> { using type = GameIntroScene; };
+template <> struct GameSceneOf<GameSceneKind::AQUARIUM_GAME> { using type = AquariumGameScene; };
+template <> struct GameSceneOf<GameSceneKind::GAME_OVER> { using type = GameOverScene; };
+template <> struct GameSceneOf<GameSceneKind::PAUSE> { using type = PauseOverlayScene; };
+template <> struct GameSceneOf<GameSceneKind::HELP> { using type = HelpOverlayScene; };
+
+// Scenes sit in a slot per kind. The bottom of the stack is the active full screen scene, overlays (pause,
+// help) are pushed on top of it. Lookups are array indexing and nothing in the frame loop builds strings
+// or allocates
 class GameSceneManager {
     public:
-        void Transition(string name);
-        void AddScene(std::shared_ptr<GameScene> newScene);
-        bool HasScenes(){return m_scenes.size() > 0; }
-        std::shared_ptr<GameScene> GetScene(string name);
-        std::shared_ptr<GameScene> GetActiveScene();
-        
-        // support the functionality
-        string GetActiveSceneName();
+        template <GameSceneKind Kind>
+        void AddScene(std::shared_ptr<typename GameSceneOf<Kind>::type> newScene) { this->AddScene(Kind, std::move(newScene)); }
+        // the scene registered under Kind with its own type, null if there is none
+        template <GameSceneKind Kind>
+        typename GameSceneOf<Kind>::type* Get() const {
+            return static_cast<typename GameSceneOf<Kind>::type*>(this->m_scenes[int(Kind)].get());
+        }
+        GameScene* GetScene(GameSceneKind kind) const { return this->m_scenes[int(kind)].get(); }
+        bool HasScenes() const { return m_depth > 0; }
+
+        // replaces the whole stack (overlays included) with the scene, preloading it first if that didn't happen yet
+        void Transition(GameSceneKind kind);
+        void Preload(GameSceneKind kind);
+        bool PushOverlay(GameSceneKind kind); // false if it's missing, already up or the stack is full
+        void RemoveOverlay(GameSceneKind kind);
+        bool HasOverlay(GameSceneKind kind) const;
+        GameSceneKind GetActiveKind() const { return m_stack[0]; }
+        GameSceneKind GetTopKind() const { return m_stack[m_depth > 0 ? m_depth - 1 : 0]; }
+        GameScene* GetActiveScene() const { return this->GetScene(this->GetActiveKind()); }
+
+        // top down until a scene blocks the ones under it
         void UpdateActiveScene();
+        // the active scene, then the overlays over it bottom up
         void DrawActiveScene();
+        void DrawOverlays();
+        // changes whenever the stack does, the overlay layer is cached on it
+        uint64_t GetStackKey() const;
 
     private:
-        std::vector<std::shared_ptr<GameScene>> m_scenes;
-        std::shared_ptr<GameScene> m_active_scene;
+        void AddScene(GameSceneKind kind, std::shared_ptr<GameScene> newScene);
+        std::array<std::shared_ptr<GameScene>, kGameSceneKindCount> m_scenes;
+        std::array<bool, kGameSceneKindCount> m_preloaded = {};
+        std::array<GameSceneKind, 4> m_stack = {};
+        size_t m_depth = 0;
 
 };
\ No newline at end of file
@@ -0,0 +1,462 @@
+#include "CreatureStore.h"
+#include "MoveKernels.h"
+#include "ThreadPool.h"
+#include "Snapshot.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include "ofMain.h"
+
+
+void CreatureStore::Reserve(size_t count, size_t sharks) {
+    x.reserve(count);
+    y.reserve(count);
+    prevX.reserve(count);
+    prevY.reserve(count);
+    dx.reserve(count);
+    dy.reserve(count);
+    speed.reserve(count);
+    radius.reserve(count);
+    value.reserve(count);
+    type.reserve(count);
+    flipped.reserve(count);
+    stepFactor.reserve(count);
+    stateIndex.reserve(count);
+    rng.reserve(count);
+    slot.reserve(count);
+    m_slots.reserve(count);
+    m_freeSlots.reserve(count);
+    m_sharks.reserve(sharks);
+    m_freeSharks.reserve(sharks);
+}
+
+size_t CreatureStore::Add(AquariumCreatureType creatureType, float px, float py, int creatureSpeed, float collisionRadius, int creatureValue) {
+    x.push_back(px);
+    y.push_back(py);
+    prevX.push_back(px);
+    prevY.push_back(py);
+    dx.push_back(0.0f);
+    dy.push_back(0.0f);
+    speed.push_back(creatureSpeed);
+    radius.push_back(collisionRadius);
+    value.push_back(creatureValue);
+    type.push_back(creatureType);
+    flipped.push_back(0);
+
+    switch (creatureType) {
+        case AquariumCreatureType::BiggerFish: stepFactor.push_back(0.5f); break; // Moves at half speed
+        case AquariumCreatureType::FastNPCreature: stepFactor.push_back(3.0f); break;
+        default: stepFactor.push_back(1.0f); break;
+    }
+
+    int state = -1;
+    if (creatureType == AquariumCreatureType::SharkCreature) {
+        if (!m_freeSharks.empty()) {
+            state = m_freeSharks.back();
+            m_freeSharks.pop_back();
+            m_sharks[state] = SharkState();
+        } else {
+            state = m_sharks.size();
+            m_sharks.emplace_back();
+        }
+        m_sharks[state].row = x.size() - 1;
+    }
+    stateIndex.push_back(state);
+    rng.push_back(m_seed ^ (++m_spawned * 0x9E3779B97F4A7C15ull));
+
+    int id;
+    if (!m_freeSlots.empty()) {
+        id = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    } else {
+        id = m_slots.size();
+        m_slots.emplace_back();
+    }
+    m_slots[id].row = x.size() - 1;
+    slot.push_back(id);
+    return x.size() - 1;
+}
+
+// same defaults the creature constructors used to set up
+size_t CreatureStore::Spawn(AquariumCreatureType creatureType, float px, float py, int creatureSpeed) {
+    float collisionRadius = 30;
+    int creatureValue = 1;
+    if (creatureType == AquariumCreatureType::BiggerFish) {
+        collisionRadius = 60; // Bigger fish have a larger collision radius
+        creatureValue = 5;    // Bigger fish have a higher value
+    }
+    size_t row = this->Add(creatureType, px, py, creatureSpeed, collisionRadius, creatureValue);
+    if (creatureType == AquariumCreatureType::NewNemoCreature) {
+        dx[row] = 1;
+        dy[row] = 1;
+    } else {
+        dx[row] = int(this->NextRandom(row) % 3) - 1; // -1, 0, or 1
+        dy[row] = int(this->NextRandom(row) % 3) - 1; // -1, 0, or 1
+    }
+    this->Normalize(row);
+    return row;
+}
+
+size_t CreatureStore::SpawnBatch(AquariumCreatureType creatureType, size_t count, const float* px, const float* py, const int* creatureSpeed) {
+    const size_t first = this->size();
+    if (first + count > x.capacity()) {
+        this->Reserve(std::max(first + count, 2 * x.capacity())); // still geometric when batches are small
+    }
+    for (size_t i = 0; i < count; ++i) {
+        this->Spawn(creatureType, px[i], py[i], creatureSpeed[i]);
+    }
+    return first;
+}
+
+template <typename T>
+static void SwapPop(std::vector<T>& column, size_t row) {
+    column[row] = column.back();
+    column.pop_back();
+}
+
+size_t CreatureStore::Remove(size_t row) {
+    if (row >= this->size()) return row;
+    if (stateIndex[row] >= 0) {
+        m_sharks[stateIndex[row]].row = -1;
+        m_freeSharks.push_back(stateIndex[row]);
+    }
+    Slot& freed = m_slots[slot[row]];
+    freed.row = -1;
+    ++freed.generation;
+    m_freeSlots.push_back(slot[row]);
+
+    // the last row takes the hole, its shark state and slot follow it
+    const size_t last = this->size() - 1;
+    if (row != last) {
+        if (stateIndex[last] >= 0) m_sharks[stateIndex[last]].row = row;
+        m_slots[slot[last]].row = row;
+    }
+    SwapPop(x, row);
+    SwapPop(y, row);
+    SwapPop(prevX, row);
+    SwapPop(prevY, row);
+    SwapPop(dx, row);
+    SwapPop(dy, row);
+    SwapPop(speed, row);
+    SwapPop(radius, row);
+    SwapPop(value, row);
+    SwapPop(type, row);
+    SwapPop(flipped, row);
+    SwapPop(stepFactor, row);
+    SwapPop(stateIndex, row);
+    SwapPop(rng, row);
+    SwapPop(slot, row);
+    return last;
+}
+
+void CreatureStore::Clear() {
+    x.clear();
+    y.clear();
+    prevX.clear();
+    prevY.clear();
+    dx.clear();
+    dy.clear();
+    speed.clear();
+    radius.clear();
+    value.clear();
+    type.clear();
+    flipped.clear();
+    stepFactor.clear();
+    stateIndex.clear();
+    rng.clear();
+    for (int id : slot) {
+        m_slots[id].row = -1;
+        ++m_slots[id].generation;
+        m_freeSlots.push_back(id);
+    }
+    slot.clear();
+    m_sharks.clear();
+    m_freeSharks.clear();
+}
+
+void CreatureStore::Normalize(size_t row) {
+    float length = std::sqrt(dx[row] * dx[row] + dy[row] * dy[row]);
+    if (length != 0) {
+        dx[row] /= length;
+        dy[row] /= length;
+    }
+}
+
+void CreatureStore::Bounce(size_t row) {
+    // -15, -20, -30, and -35 are used as offsets to better match the screen size
+    // speed != 5 is checked to differentiate the player from most NPCs
+    //      as the player has a default speed of 5 but most NPCs don't, and
+    //      they should not behave in the same manner
+    if (x[row] < -15) {
+        x[row] = -15;
+        if (speed[row] != 5)
+            dx[row] *= -1;
+    }
+    if (x[row] > m_width - 35) {
+        x[row] = m_width - 35;
+        if (speed[row] != 5)
+            dx[row] *= -1;
+    }
+    if (y[row] < -20) {
+        y[row] = -20;
+        if (speed[row] != 5)
+            dy[row] *= -1;
+    }
+    if (y[row] > m_height - 30) {
+        y[row] = m_height - 30;
+        if (speed[row] != 5)
+            dy[row] *= -1;
+    }
+}
+
+// the movement each species used to do in its own move() override
+void CreatureStore::Move(size_t row, float step) {
+    switch (type[row]) {
+        case AquariumCreatureType::NPCreature:
+            // Simple AI movement logic (random direction)
+            x[row] += dx[row] * speed[row] * step;
+            y[row] += dy[row] * speed[row] * step;
+            break;
+        case AquariumCreatureType::BiggerFish:
+            // Bigger fish might move slower or have different logic
+            x[row] += dx[row] * (speed[row] * 0.5) * step; // Moves at half speed
+            y[row] += dy[row] * (speed[row] * 0.5) * step;
+            break;
+        case AquariumCreatureType::FastNPCreature:
+            //As the name suggests, this new fish moves faster, Lightning McQueen fast
+            x[row] += dx[row] * speed[row] * 3 * step;
+            y[row] += dy[row] * speed[row] * 3 * step;
+            break;
+        case AquariumCreatureType::NewNemoCreature:
+            x[row] += dx[row] * speed[row] * step;
+            y[row] += sin(x[row] * 0.06f) * 4.0f * step;  //moves like the sine functions cause why not
+            break;
+        case AquariumCreatureType::SharkCreature: {
+            //Fish starts with boost and rest. The boost first gets depleted and then we have rest
+            SharkState& shark = this->getSharkState(row);
+            if (shark.boostTimer > 0) {
+                x[row] += dx[row] * speed[row] * 3 * step;
+                y[row] += dy[row] * speed[row] * 3 * step;
+                shark.boostTimer -= step;
+            } else if (shark.restTimer > 0) {
+                x[row] += dx[row] * speed[row] * step;
+                y[row] += dy[row] * speed[row] * step;
+                shark.restTimer -= step;
+            } else {
+                //After rest and boost are finished, we set the timer for rest and boost to random to add suspense...
+                shark.boostTimer = int(this->RandomRange(row, 10, 20));
+                shark.restTimer = int(this->RandomRange(row, 5, 12));
+            }
+            break;
+        }
+    }
+    flipped[row] = dx[row] < 0;
+    this->Bounce(row);
+}
+
+void CreatureStore::MoveAllReference(float step) {
+    const size_t count = this->size();
+    for (size_t row = 0; row < count; ++row) {
+        this->Move(row, step);
+    }
+}
+
+void CreatureStore::SavePrevious() {
+    std::copy(x.begin(), x.end(), prevX.begin());
+    std::copy(y.begin(), y.end(), prevY.begin());
+}
+
+// same decisions as the shark case of Move(), the position update is left to the kernel
+void CreatureStore::AdvanceSharkTimers(float step) {
+    for (SharkState& shark : m_sharks) {
+        if (shark.row < 0) continue;
+        if (shark.boostTimer > 0) {
+            stepFactor[shark.row] = 3.0f;
+            shark.boostTimer -= step;
+        } else if (shark.restTimer > 0) {
+            stepFactor[shark.row] = 1.0f;
+            shark.restTimer -= step;
+        } else {
+            stepFactor[shark.row] = 0.0f; // recharging, doesn't move this tick
+            shark.boostTimer = int(this->RandomRange(shark.row, 10, 20));
+            shark.restTimer = int(this->RandomRange(shark.row, 5, 12));
+        }
+    }
+}
+
+void CreatureStore::MoveAllWith(MoveKernel kernel, float step) {
+    this->AdvanceSharkTimers(step);
+    MoveColumns columns{x.data(), y.data(), dx.data(), dy.data(), speed.data(), stepFactor.data(),
+                        type.data(), flipped.data(), m_width, m_height, step};
+    kernel(columns, 0, this->size());
+}
+
+void CreatureStore::MoveAll(float step) {
+    this->MoveAllWith(SelectMoveKernel().kernel, step);
+}
+
+// Sharks timers go first on this thread (there are few of them), then every chunk only touches its own rows
+void CreatureStore::MoveAllParallel(ThreadPool& pool, float step) {
+    const size_t kRowsPerChunk = 4096;
+    this->AdvanceSharkTimers(step);
+    MoveColumns columns{x.data(), y.data(), dx.data(), dy.data(), speed.data(), stepFactor.data(),
+                        type.data(), flipped.data(), m_width, m_height, step};
+    MoveKernel kernel = SelectMoveKernel().kernel;
+    pool.ParallelFor(this->size(), kRowsPerChunk, [&](size_t begin, size_t end) {
+        kernel(columns, begin, end);
+    });
+}
+
+uint32_t CreatureStore::NextRandom(size_t row) {
+    uint64_t z = (rng[row] += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return uint32_t((z ^ (z >> 31)) >> 32);
+}
+
+float CreatureStore::RandomRange(size_t row, float low, float high) {
+    return low + (high - low) * ((this->NextRandom(row) >> 8) * (1.0f / 16777216.0f)); // 24 bits, never reaches 1
+}
+
+size_t CreatureStore::getMemoryBytes() const {
+    return x.capacity() * sizeof(float) + y.capacity() * sizeof(float)
+         + prevX.capacity() * sizeof(float) + prevY.capacity() * sizeof(float)
+         + dx.capacity() * sizeof(float) + dy.capacity() * sizeof(float)
+         + speed.capacity() * sizeof(int) + radius.capacity() * sizeof(float)
+         + value.capacity() * sizeof(int) + type.capacity() * sizeof(AquariumCreatureType)
+         + flipped.capacity() * sizeof(uint8_t) + stepFactor.capacity() * sizeof(float)
+         + stateIndex.capacity() * sizeof(int) + rng.capacity() * sizeof(uint64_t)
+         + slot.capacity() * sizeof(int) + m_slots.capacity() * sizeof(Slot) + m_freeSlots.capacity() * sizeof(int)
+         + m_sharks.capacity() * sizeof(SharkState) + m_freeSharks.capacity() * sizeof(int);
+}
+
+void CreatureStore::Save(SnapshotWriter& out) const {
+    out.Write(m_width);
+    out.Write(m_height);
+    out.Write(m_seed);
+    out.Write(m_spawned);
+    out.WriteArray(x);
+    out.WriteArray(y);
+    out.WriteArray(prevX);
+    out.WriteArray(prevY);
+    out.WriteArray(dx);
+    out.WriteArray(dy);
+    out.WriteArray(speed);
+    out.WriteArray(radius);
+    out.WriteArray(value);
+    out.WriteArray(type);
+    out.WriteArray(flipped);
+    out.WriteArray(stepFactor);
+    out.WriteArray(stateIndex);
+    out.WriteArray(rng);
+    out.WriteArray(slot);
+    out.WriteArray(m_sharks);
+    out.WriteArray(m_freeSharks);
+    out.WriteArray(m_slots);
+    out.WriteArray(m_freeSlots);
+}
+
+bool CreatureStore::Load(SnapshotReader& in) {
+    in.Read(m_width);
+    in.Read(m_height);
+    in.Read(m_seed);
+    in.Read(m_spawned);
+    in.ReadArray(x);
+    in.ReadArray(y);
+    in.ReadArray(prevX);
+    in.ReadArray(prevY);
+    in.ReadArray(dx);
+    in.ReadArray(dy);
+    in.ReadArray(speed);
+    in.ReadArray(radius);
+    in.ReadArray(value);
+    in.ReadArray(type);
+    in.ReadArray(flipped);
+    in.ReadArray(stepFactor);
+    in.ReadArray(stateIndex);
+    in.ReadArray(rng);
+    in.ReadArray(slot);
+    in.ReadArray(m_sharks);
+    in.ReadArray(m_freeSharks);
+    in.ReadArray(m_slots);
+    in.ReadArray(m_freeSlots);
+
+    if (!in.isGood() || !this->IsConsistent()) {
+        in.Fail();
+        this->Reset(); // Clear() would follow slot[], which can't be trusted here
+    }
+    return in.isGood();
+}
+
+// Rows have to line up across every column, and the slot and shark tables have to point back at the rows
+// that point at them, with everything else in the free lists exactly once. Anything a later Remove, Clear
+// or shark update would index with is checked here
+bool CreatureStore::IsConsistent() const {
+    const size_t count = x.size();
+    if (!std::isfinite(m_width) || !std::isfinite(m_height)) return false;
+    if (y.size() != count || prevX.size() != count || prevY.size() != count || dx.size() != count
+        || dy.size() != count || speed.size() != count || radius.size() != count || value.size() != count
+        || type.size() != count || flipped.size() != count || stepFactor.size() != count
+        || stateIndex.size() != count || rng.size() != count || slot.size() != count) {
+        return false;
+    }
+    size_t sharkRows = 0;
+    for (size_t row = 0; row < count; ++row) {
+        if (int(type[row]) < 0 || int(type[row]) >= kAquariumCreatureTypeCount) return false;
+        if (!std::isfinite(x[row]) || !std::isfinite(y[row]) || !std::isfinite(prevX[row]) || !std::isfinite(prevY[row])
+            || !std::isfinite(dx[row]) || !std::isfinite(dy[row])) {
+            return false;
+        }
+        // a slot points at exactly one row, so two rows can't share one
+        if (slot[row] < 0 || size_t(slot[row]) >= m_slots.size() || m_slots[slot[row]].row != int(row)) return false;
+        bool shark = type[row] == AquariumCreatureType::SharkCreature;
+        if (shark != (stateIndex[row] >= 0)) return false;
+        if (shark) ++sharkRows;
+        if (shark && (size_t(stateIndex[row]) >= m_sharks.size() || m_sharks[stateIndex[row]].row != int(row))) return false;
+    }
+
+    size_t usedSlots = 0;
+    for (const Slot& s : m_slots) {
+        if (s.row < -1 || s.row >= int(count)) return false;
+        if (s.row >= 0) ++usedSlots;
+    }
+    std::vector<uint8_t> listed(m_slots.size(), 0);
+    for (int id : m_freeSlots) {
+        if (id < 0 || size_t(id) >= m_slots.size() || m_slots[id].row != -1 || listed[id]++) return false;
+    }
+    if (usedSlots != count || usedSlots + m_freeSlots.size() != m_slots.size()) return false;
+
+    size_t usedSharks = 0;
+    for (const SharkState& s : m_sharks) {
+        if (s.row < -1 || s.row >= int(count)) return false;
+        if (s.row >= 0) ++usedSharks;
+    }
+    listed.assign(m_sharks.size(), 0);
+    for (int id : m_freeSharks) {
+        if (id < 0 || size_t(id) >= m_sharks.size() || m_sharks[id].row != -1 || listed[id]++) return false;
+    }
+    return usedSharks == sharkRows && usedSharks + m_freeSharks.size() == m_sharks.size();
+}
+
+// empties every column and table without looking at their contents
+void CreatureStore::Reset() {
+    x.clear();
+    y.clear();
+    prevX.clear();
+    prevY.clear();
+    dx.clear();
+    dy.clear();
+    speed.clear();
+    radius.clear();
+    value.clear();
+    type.clear();
+    flipped.clear();
+    stepFactor.clear();
+    stateIndex.clear();
+    rng.clear();
+    slot.clear();
+    m_sharks.clear();
+    m_freeSharks.clear();
+    m_slots.clear();
+    m_freeSlots.clear();
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+enum class AquariumCreatureType {
+    NPCreature,
+    BiggerFish,
+    FastNPCreature,   //added new fish species
+    NewNemoCreature,   //added new fish species
+    SharkCreature      //added final new fish species
+};
+const int kAquariumCreatureTypeCount = 5;
+
+struct MoveColumns; // MoveKernels.h
+class ThreadPool;
+class SnapshotWriter; // Snapshot.h
+class SnapshotReader;
+
+// Stable name for a creature of a store. Rows move when another row is removed, a handle goes through the
+// store's slot table instead, and the slot's generation changes once the creature is gone, so a handle kept
+// around (an old GameEvent, a view) resolves to nothing rather than to whatever fish took the row
+struct CreatureHandle {
+    int slot = -1;
+    uint32_t generation = 0;
+    bool isValid() const { return slot >= 0; }
+};
+
+// Boost/rest timers, only sharks carry one. Counted in movement steps, a tick can cover a fraction of one
+struct SharkState {
+    float boostTimer = 10;
+    float restTimer = 5;
+    int row = -1; // row this state belongs to, -1 while it sits in the free list
+};
+
+
+// Data oriented storage for creatures: one contiguous array per field instead of one heap object per fish.
+// Creature/NPCreature objects are views over a row of a store (see Core.h), a standalone creature
+// like the player simply owns a store with a single row.
+// Removing a row moves the last row into its place, so a row number (and a view) is only valid until the
+// next Remove/Clear; keep a CreatureHandle to refer to a creature across removals
+class CreatureStore {
+public:
+    // world bounds are shared by every row instead of copied into each creature
+    void setBounds(float width, float height) { m_width = width; m_height = height; }
+    float getWidth() const { return m_width; }
+    float getHeight() const { return m_height; }
+
+    size_t size() const { return x.size(); }
+    // every row gets its own random stream derived from this seed and its spawn order, so what a creature
+    // rolls doesn't depend on which thread moves it or on what other creatures rolled
+    void setSeed(uint64_t seed) { m_seed = seed; }
+    // room for count rows, sharks of them with boost/rest state, so spawning up to that never allocates
+    void Reserve(size_t count, size_t sharks = 0);
+    // Adds a row with the species defaults (direction, collision radius, value, timers)
+    size_t Spawn(AquariumCreatureType creatureType, float x, float y, int speed);
+    // count rows of one species, storage grows at most once for the whole batch. Returns the first new row,
+    // the batch is the rows [first, first + count)
+    size_t SpawnBatch(AquariumCreatureType creatureType, size_t count, const float* x, const float* y, const int* speed);
+    // Adds a row with explicit values, nothing is randomized
+    size_t Add(AquariumCreatureType creatureType, float x, float y, int speed, float collisionRadius, int value);
+    // swap and pop: the last row moves into row, returns the row it came from (== row when it was the last)
+    size_t Remove(size_t row);
+    void Clear(); // keeps the capacity for the next level, every handle goes stale
+
+    CreatureHandle getHandle(size_t row) const { return {slot[row], m_slots[slot[row]].generation}; }
+    // row of the creature, -1 if it has been removed since the handle was taken
+    int Resolve(CreatureHandle handle) const {
+        if (!handle.isValid() || size_t(handle.slot) >= m_slots.size()) return -1;
+        const Slot& s = m_slots[handle.slot];
+        return s.generation == handle.generation ? s.row : -1;
+    }
+
+    // species movement of one row, followed by the boundary bounce. This is the reference behavior.
+    // step scales the movement, 1 is one full step of the original per species logic
+    void Move(size_t row, float step = 1.0f);
+    // every row through the widest vector kernel the cpu has (see MoveKernels.h)
+    void MoveAll(float step = 1.0f);
+    void MoveAllWith(void (*kernel)(const MoveColumns&, size_t, size_t), float step = 1.0f);
+    void MoveAllReference(float step = 1.0f);
+    // same as MoveAll with the rows split in chunks across the pool, the result doesn't depend on the thread count
+    void MoveAllParallel(ThreadPool& pool, float step = 1.0f);
+    // copies x/y into prevX/prevY, called before a tick moves anything so draw can interpolate
+    void SavePrevious();
+    void Normalize(size_t row);
+    void Bounce(size_t row);
+
+    SharkState& getSharkState(size_t row) { return m_sharks[stateIndex[row]]; }
+    uint32_t NextRandom(size_t row);
+    float RandomRange(size_t row, float low, float high); // [low, high)
+    size_t getMemoryBytes() const;
+    // every column plus the shark state and slot tables, handles taken before a save still resolve after a load.
+    // A Load that fails the checks leaves the store empty
+    void Save(SnapshotWriter& out) const;
+    bool Load(SnapshotReader& in);
+
+    // columns, public so the hot loops (update, collisions, draw) can walk them directly
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> prevX; // position before the last tick
+    std::vector<float> prevY;
+    std::vector<float> dx;
+    std::vector<float> dy;
+    std::vector<int> speed;
+    std::vector<float> radius;
+    std::vector<int> value;
+    std::vector<AquariumCreatureType> type;
+    std::vector<uint8_t> flipped;
+    std::vector<float> stepFactor; // per species speed multiplier, sharks update theirs every tick
+    std::vector<int> stateIndex; // into the sparse per type state (sharks), -1 if none
+    std::vector<uint64_t> rng;   // per row random state (splitmix64)
+    std::vector<int> slot;       // into the slot table, what handles point at
+
+private:
+    struct Slot {
+        int row = -1;            // -1 while free
+        uint32_t generation = 0; // bumped every time the slot is freed
+    };
+
+    // the branchy part of shark movement, runs before the kernels and leaves each shark's stepFactor
+    void AdvanceSharkTimers(float step);
+    bool IsConsistent() const; // after a Load
+    void Reset();
+
+    float m_width = 0.0f;
+    float m_height = 0.0f;
+    uint64_t m_seed = 0x5eed;
+    uint64_t m_spawned = 0;
+    std::vector<SharkState> m_sharks;
+    std::vector<int> m_freeSharks;
+    std::vector<Slot> m_slots;
+    std::vector<int> m_freeSlots;
+};
@@ -0,0 +1,162 @@
+#include "Headless.h"
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+
+void HeadlessBot::Steer(PlayerCreature& player, const Aquarium& aquarium) const {
+    const CreatureStore& s = aquarium.getCreatureStore();
+    const float px = player.getX();
+    const float py = player.getY();
+    const float dangerRadius = 160.0f;
+
+    float targetX = px;
+    float targetY = py;
+    float closest = -1.0f;
+    float awayX = 0.0f;
+    float awayY = 0.0f;
+    for (size_t i = 0; i < s.size(); ++i) {
+        float dx = s.x[i] - px;
+        float dy = s.y[i] - py;
+        float distance = std::sqrt(dx * dx + dy * dy) + 0.001f;
+        if (s.value[i] <= player.getPower()) {
+            if (closest < 0 || distance < closest) {
+                closest = distance;
+                targetX = s.x[i];
+                targetY = s.y[i];
+            }
+        } else if (distance < dangerRadius) {
+            // the closer the threat, the harder we turn away from it
+            float weight = (dangerRadius - distance) / dangerRadius;
+            awayX -= dx / distance * weight * 3.0f;
+            awayY -= dy / distance * weight * 3.0f;
+        }
+    }
+
+    float steerX = awayX;
+    float steerY = awayY;
+    if (closest >= 0) {
+        steerX += (targetX - px) / closest;
+        steerY += (targetY - py) / closest;
+    }
+    // round to the arrow keys a person would be holding
+    float dirX = steerX > 0.3f ? 1.0f : (steerX < -0.3f ? -1.0f : 0.0f);
+    float dirY = steerY > 0.3f ? 1.0f : (steerY < -0.3f ? -1.0f : 0.0f);
+    player.setDirection(dirX, dirY);
+}
+
+
+bool LoadInputScript(const std::string& path, std::vector<ScriptedInput>& script) {
+    std::ifstream file(path);
+    if (!file) {
+        ofLogError() << "Can't open input script " << path;
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        ScriptedInput input;
+        if (fields >> input.tick >> input.dx >> input.dy) {
+            script.push_back(input);
+        }
+    }
+    return true;
+}
+
+
+int RunHeadless(const HeadlessOptions& requested) {
+    HeadlessOptions options = requested;
+    int width = 1024;
+    int height = 768;
+    ofSetLogLevel(OF_LOG_NOTICE);
+
+    std::vector<ScriptedInput> script;
+    if (!options.scriptPath.empty() && !LoadInputScript(options.scriptPath, script)) {
+        return 1;
+    }
+    // a replay is the recorded session as fast as possible, the run is whatever the recording says
+    InputRecordingHeader recording;
+    std::vector<InputRecord> replay;
+    if (!options.replayPath.empty()) {
+        if (!LoadInputRecording(options.replayPath, recording, replay)) {
+            return 1;
+        }
+        options.seed = recording.seed;
+        options.tickRate = recording.tickRate;
+        options.lives = recording.lives;
+        options.maxTicks = recording.ticks;
+        width = recording.width;
+        height = recording.height;
+    }
+
+    // null sprite backend: the atlas only records regions, nothing is decoded or uploaded
+    auto spriteManager = std::make_shared<AquariumSpriteManager>(false);
+    auto aquarium = std::make_shared<Aquarium>(width, height, spriteManager);
+    aquarium->setSeed(options.seed);
+    auto player = std::make_shared<PlayerCreature>(width/2 - 50, height/2 - 50, 5, spriteManager->GetSprite(AquariumCreatureType::NPCreature));
+    player->setDirection(0, 0);
+    player->setBounds(width - 20, height - 20);
+    player->setLives(options.lives);
+    AddGameLevels(aquarium);
+    aquarium->Repopulate();
+
+    AquariumGameScene scene(player, aquarium, GameSceneKindToString(GameSceneKind::AQUARIUM_GAME));
+    scene.SetTickRate(options.tickRate);
+    scene.SetReplay(std::move(replay));
+    if (!options.snapshotPath.empty() && !scene.LoadSnapshot(options.snapshotPath)) {
+        return 1;
+    }
+    Trace::SetEnabled(!options.tracePath.empty());
+    InputRecorder recorder;
+    if (!options.recordPath.empty()) {
+        recorder.Start(options.recordPath, options.seed, options.tickRate, width, height, options.lives);
+    }
+
+    HeadlessBot bot;
+    size_t nextInput = 0;
+    long long tick = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (; tick < options.maxTicks; ++tick) {
+        float lastDx = player->getDx();
+        float lastDy = player->getDy();
+        if (scene.IsReplaying()) {
+            // the scene applies the recording itself
+        } else if (script.empty()) {
+            bot.Steer(*player, *aquarium);
+        } else {
+            while (nextInput < script.size() && script[nextInput].tick <= tick) {
+                player->setDirection(script[nextInput].dx, script[nextInput].dy);
+                ++nextInput;
+            }
+        }
+        if (player->getDx() != lastDx || player->getDy() != lastDy) {
+            recorder.Record(player->CaptureInput(scene.GetTick()));
+        }
+        scene.Simulate(1);
+        bool levelsDone = !scene.IsReplaying() && aquarium->getCurrentLevel() >= options.levels;
+        if (scene.GetLastEvent().isGameOver() || levelsDone) {
+            ++tick;
+            break;
+        }
+    }
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    recorder.Finish(tick);
+    if (!options.tracePath.empty()) {
+        Trace::Dump(options.tracePath);
+    }
+    if (!options.saveSnapshotPath.empty()) {
+        scene.SaveSnapshot(options.saveSnapshotPath);
+    }
+
+    // a replay counts as done once it played the whole recording, however the session ended
+    bool completed = scene.IsReplaying() || aquarium->getCurrentLevel() >= options.levels;
+    const char* outcome = scene.GetLastEvent().isGameOver() ? "game over"
+                        : (scene.IsReplaying() ? "replay finished" : (completed ? "levels completed" : "out of ticks"));
+    ofLogNotice() << "Headless run: " << outcome << " after " << tick << " ticks (" << tick / options.tickRate
+                  << " s of game time) in " << wallSeconds * 1000.0 << " ms, " << tick / std::max(wallSeconds, 1e-9)
+                  << " ticks/s | level " << aquarium->getCurrentLevel() << ", score " << player->getScore()
+                  << ", power " << player->getPower() << ", lives " << player->getLives() << ", seed " << options.seed;
+    return completed ? 0 : 1;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Aquarium.h"
+
+
+// Options of a --headless run
+struct HeadlessOptions {
+    double tickRate = 60.0;
+    long long maxTicks = 60LL * 60 * 60;   // an hour of game time at 60 ticks per second
+    int levels = 5;                        // stop once this many levels were completed (all of Level_0..Level_4)
+    uint64_t seed = 1;
+    int lives = 3;
+    std::string scriptPath;                // "tick dx dy" per line, the bot plays when empty
+    std::string replayPath;                // --replay: recorded session, its seed, rate and length win over the above
+    std::string recordPath;                // --record: writes whatever input was played (bot, script) as a recording
+    std::string snapshotPath;              // --snapshot: continues a saved game instead of starting at level 0
+    std::string saveSnapshotPath;          // --save-snapshot: the state the run ended in
+    std::string tracePath;                 // --trace: the whole run is traced and dumped here at the end
+};
+
+// Player input for a headless run: direction changes at given ticks
+struct ScriptedInput {
+    long long tick;
+    float dx;
+    float dy;
+};
+
+// Plays the game the way a cautious player would: go for the closest fish it can eat (or the power up),
+// and steer away from anything it can't eat that gets close
+class HeadlessBot {
+public:
+    void Steer(PlayerCreature& player, const Aquarium& aquarium) const;
+};
+
+// Runs the full game loop (player, collisions, power ups, level progression) without a window, GL context,
+// textures, fonts or audio, as fast as the cpu allows. Sprites only describe their atlas region and are never
+// decoded. Returns the process exit code: 0 when every level was completed, 1 on game over or timeout
+int RunHeadless(const HeadlessOptions& options);
+
+bool LoadInputScript(const std::string& path, std::vector<ScriptedInput>& script);
@@ -0,0 +1,76 @@
+#include "Hud.h"
+#include <cmath>
+#include <cstdio>
+#include "Core.h"
+
+
+void HudText::SetPosition(float x, float y) {
+    if (x == m_x && y == m_y) return;
+    m_x = x;
+    m_y = y;
+    m_builtWith = nullptr;
+}
+
+void HudText::Format(char* out, size_t size, int value) const {
+    if (m_value) {
+        std::snprintf(out, size, "%s%d", m_label, value);
+    } else {
+        std::snprintf(out, size, "%s", m_label);
+    }
+}
+
+void HudText::Draw(const ofTrueTypeFont* font) {
+    int value = m_value ? m_value() : 0;
+    char text[128];
+    if (font == nullptr || !font->isLoaded()) {
+        this->Format(text, sizeof(text), value);
+        ofDrawBitmapString(text, m_x, m_y);
+        return;
+    }
+    if (m_builtWith != font || value != m_shownValue) {
+        this->Format(text, sizeof(text), value);
+        m_mesh.clear();
+        m_mesh.append(font->getStringMesh(text, m_x, m_y));
+        m_shownValue = value;
+        m_builtWith = font;
+    }
+    font->getFontTexture().bind();
+    m_mesh.draw();
+    font->getFontTexture().unbind();
+    RenderStats::CountDrawCall();
+}
+
+
+void HudCircles::SetPosition(float x, float y) {
+    if (x == m_x && y == m_y) return;
+    m_x = x;
+    m_y = y;
+    m_shownCount = -1;
+}
+
+void HudCircles::Draw() {
+    int count = std::max(0, m_count());
+    if (count != m_shownCount) {
+        // a fan of triangles per circle, all of them in one mesh
+        const int segments = 16;
+        m_mesh.clear();
+        m_mesh.setMode(OF_PRIMITIVE_TRIANGLES);
+        for (int i = 0; i < count; ++i) {
+            float centerX = m_x + i * m_spacing;
+            unsigned int first = m_mesh.getNumVertices();
+            m_mesh.addVertex(glm::vec3(centerX, m_y, 0));
+            for (int s = 0; s < segments; ++s) {
+                float angle = TWO_PI * s / segments;
+                m_mesh.addVertex(glm::vec3(centerX + std::cos(angle) * m_radius, m_y + std::sin(angle) * m_radius, 0));
+                m_mesh.addIndex(first);
+                m_mesh.addIndex(first + 1 + s);
+                m_mesh.addIndex(first + 1 + (s + 1) % segments);
+            }
+        }
+        m_shownCount = count;
+    }
+    if (count == 0) return;
+    ofSetColor(m_color);
+    m_mesh.draw();
+    RenderStats::CountDrawCall();
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <functional>
+#include "ofMain.h"
+
+
+// One line of HUD text, kept as a mesh over the font's glyph atlas (the ofTrueTypeFont texture). The text is
+// only formatted and the mesh built again when the bound value or the position changes, drawing it is a single
+// textured draw. Without a loaded font it falls back to ofDrawBitmapString
+class HudText {
+public:
+    // value: the number shown after the label, none for a fixed label
+    HudText(const char* label, float x, float y, std::function<int()> value = nullptr)
+    : m_label(label), m_x(x), m_y(y), m_value(std::move(value)) {}
+    void SetPosition(float x, float y);
+    void Draw(const ofTrueTypeFont* font);
+
+private:
+    void Format(char* out, size_t size, int value) const;
+    const char* m_label;
+    float m_x;
+    float m_y;
+    std::function<int()> m_value;
+    int m_shownValue = 0;
+    const ofTrueTypeFont* m_builtWith = nullptr; // null until the mesh was built
+    ofVboMesh m_mesh;
+};
+
+// A row of filled circles, one per unit of the bound value (the player's lives), all in one mesh
+class HudCircles {
+public:
+    HudCircles(float x, float y, float radius, float spacing, ofColor color, std::function<int()> count)
+    : m_x(x), m_y(y), m_radius(radius), m_spacing(spacing), m_color(color), m_count(std::move(count)) {}
+    void SetPosition(float x, float y);
+    void Draw();
+
+private:
+    float m_x;
+    float m_y;
+    float m_radius;
+    float m_spacing;
+    ofColor m_color;
+    std::function<int()> m_count;
+    int m_shownCount = -1; // -1 until the mesh was built
+    ofVboMesh m_mesh;
+};
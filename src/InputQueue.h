@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+
+// A key as it arrived, stamped with ofGetElapsedTimeMicros() in the key callback
+struct InputEvent {
+    uint64_t micros;
+    int key;
+    bool pressed;
+};
+
+// Single producer (the key callbacks) single consumer (the simulation tick) ring. Lock free, so neither side
+// ever waits on the other even if the simulation moves to its own thread. A full ring drops the event
+class InputQueue {
+public:
+    bool Push(const InputEvent& event) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == kCapacity) {
+            ++m_dropped;
+            return false;
+        }
+        m_events[tail & (kCapacity - 1)] = event;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    bool Pop(InputEvent& event) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) return false;
+        event = m_events[head & (kCapacity - 1)];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    size_t getDropped() const { return m_dropped; }
+
+private:
+    static constexpr size_t kCapacity = 256; // power of two, far more than a frame's worth of keys
+    InputEvent m_events[kCapacity];
+    std::atomic<size_t> m_head{0};
+    std::atomic<size_t> m_tail{0};
+    size_t m_dropped = 0; // producer side only
+};
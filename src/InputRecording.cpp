@@ -0,0 +1,58 @@
+#include "InputRecording.h"
+#include <cstring>
+#include <fstream>
+#include "AssetPack.h"
+#include "ofMain.h"
+
+
+void InputRecorder::Start(const std::string& path, uint64_t seed, double tickRate, int width, int height, int lives) {
+    m_path = path;
+    std::memcpy(m_header.magic, "AQIN", 4);
+    m_header.version = kInputRecordingVersion;
+    m_header.seed = seed;
+    m_header.tickRate = tickRate;
+    m_header.width = width;
+    m_header.height = height;
+    m_header.lives = lives;
+    m_records.clear();
+    m_records.reserve(4096); // about an hour of frantic key presses
+    ofLogNotice() << "Recording input to " << path;
+}
+
+bool InputRecorder::Finish(uint64_t ticks) {
+    if (!this->isRecording()) return false;
+    m_header.recordCount = m_records.size();
+    m_header.ticks = ticks;
+
+    std::ofstream out(m_path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+    out.write(reinterpret_cast<const char*>(m_records.data()), m_records.size() * sizeof(InputRecord));
+    bool written = bool(out);
+    if (written) {
+        ofLogNotice() << "Recorded " << m_records.size() << " inputs over " << ticks << " ticks to " << m_path;
+    } else {
+        ofLogError() << "Failed to write the input recording " << m_path;
+    }
+    m_path.clear();
+    return written;
+}
+
+bool LoadInputRecording(const std::string& path, InputRecordingHeader& header, std::vector<InputRecord>& records) {
+    MappedFile file;
+    if (!file.Open(path) || file.size() < sizeof(InputRecordingHeader)) {
+        ofLogError() << "Can't open input recording " << path;
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, "AQIN", 4) != 0 || header.version != kInputRecordingVersion) {
+        ofLogError() << "Input recording " << path << " has the wrong format or version";
+        return false;
+    }
+    if (sizeof(header) + size_t(header.recordCount) * sizeof(InputRecord) > file.size()) {
+        ofLogError() << "Input recording " << path << " is truncated";
+        return false;
+    }
+    const InputRecord* first = reinterpret_cast<const InputRecord*>(file.data() + sizeof(header));
+    records.assign(first, first + header.recordCount);
+    return true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// On disk layout of a recorded session (little endian, fixed size structs):
+//   InputRecordingHeader
+//   InputRecord x recordCount
+// Everything else about the run follows from the seed, so this is all a replay needs
+struct InputRecordingHeader {
+    char magic[4];          // "AQIN"
+    uint32_t version;
+    uint64_t seed;          // Aquarium::setSeed
+    double tickRate;
+    uint32_t width;         // window the aquarium was set up for
+    uint32_t height;
+    int32_t lives;
+    uint32_t recordCount;
+    uint64_t ticks;         // length of the session in ticks
+};
+
+// Player input as it reached the player: its direction once the keys of the tick were applied (already normalized, kept
+// as is so the replay moves bit for bit the same), applied right before the tick it was recorded at
+struct InputRecord {
+    uint32_t tick;
+    float dx;
+    float dy;
+    uint8_t flags;
+    uint8_t reserved[3];
+};
+
+static_assert(sizeof(InputRecordingHeader) == 48, "recording header layout changed");
+static_assert(sizeof(InputRecord) == 16, "input record layout changed");
+
+const uint32_t kInputRecordingVersion = 1;
+const uint8_t kInputFlipped = 1; // sprite faces left
+const uint8_t kInputNudge = 2;   // only in older recordings, the key handler also moved the player right away
+
+
+// Keeps the session in memory, Finish() writes the file once (on exit)
+class InputRecorder {
+public:
+    void Start(const std::string& path, uint64_t seed, double tickRate, int width, int height, int lives);
+    bool isRecording() const { return !m_path.empty(); }
+    void Record(const InputRecord& record) { if (isRecording()) m_records.push_back(record); }
+    bool Finish(uint64_t ticks);
+
+private:
+    std::string m_path;
+    InputRecordingHeader m_header = {};
+    std::vector<InputRecord> m_records;
+};
+
+bool LoadInputRecording(const std::string& path, InputRecordingHeader& header, std::vector<InputRecord>& records);
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "ofMain.h"
+
+
+// Verbose logs are for debugging. Outside debug builds the calls, and the formatting of their arguments,
+// are compiled out. -DAQUARIUM_VERBOSE_LOGS=1 (PROJECT_DEFINES in config.make) keeps them in a release build
+#ifndef AQUARIUM_VERBOSE_LOGS
+#if defined(DEBUG) || defined(_DEBUG)
+#define AQUARIUM_VERBOSE_LOGS 1
+#else
+#define AQUARIUM_VERBOSE_LOGS 0
+#endif
+#endif
+
+// Used like ofLogVerbose(): AQ_LOG_VERBOSE() << "x " << x;
+// Compiled in, the log level is checked before an ofLog is built. Compiled out, the statement is still type
+// checked but is dead code
+#if AQUARIUM_VERBOSE_LOGS
+#define AQ_LOG_VERBOSE() if (ofGetLogLevel() > OF_LOG_VERBOSE) {} else ofLogVerbose()
+#else
+#define AQ_LOG_VERBOSE() if (true) {} else ofLogVerbose()
+#endif
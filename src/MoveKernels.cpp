@@ -0,0 +1,354 @@
+#include "MoveKernels.h"
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include "Random.h"
+#include "ThreadPool.h"
+#include <cmath>
+#include "ofMain.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define AQUARIUM_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AQUARIUM_TARGET(isa)
+#else
+#define AQUARIUM_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+static_assert(sizeof(AquariumCreatureType) == sizeof(int32_t), "kernels load the type column as int32");
+static_assert(int(AquariumCreatureType::NewNemoCreature) == 3, "kernels compare against the NewNemo value");
+
+
+// Scalar fallback, also the tail of the vector kernels
+static void MoveScalar(const MoveColumns& c, size_t begin, size_t end) {
+    const float right = c.width - 35;
+    const float bottom = c.height - 30;
+    for (size_t i = begin; i < end; ++i) {
+        float speed = float(c.speed[i]);
+        float factor = c.stepFactor[i] * c.step;
+        float x = c.x[i] + c.dx[i] * speed * factor;
+        float y;
+        if (c.type[i] == AquariumCreatureType::NewNemoCreature) {
+            y = c.y[i] + std::sin(x * 0.06f) * 4.0f * c.step;
+        } else {
+            y = c.y[i] + c.dy[i] * speed * factor;
+        }
+        c.flipped[i] = c.dx[i] < 0;
+
+        bool canReflect = c.speed[i] != 5; // the player check from Creature::bounce
+        if (x < -15) { x = -15; if (canReflect) c.dx[i] *= -1; }
+        if (x > right) { x = right; if (canReflect) c.dx[i] *= -1; }
+        if (y < -20) { y = -20; if (canReflect) c.dy[i] *= -1; }
+        if (y > bottom) { y = bottom; if (canReflect) c.dy[i] *= -1; }
+        c.x[i] = x;
+        c.y[i] = y;
+    }
+}
+
+
+#ifdef AQUARIUM_X86
+
+// sin() of 4 floats, cephes style: range reduction by pi/4 and minimax polynomials
+AQUARIUM_TARGET("sse4.1")
+static inline __m128 SinSSE(__m128 x) {
+    const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(int(0x80000000)));
+    __m128 signBit = _mm_and_ps(x, signMask);
+    x = _mm_andnot_ps(signMask, x);
+
+    __m128i j = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.27323954473516f))); // 4/pi
+    j = _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+    __m128 y = _mm_cvtepi32_ps(j);
+    __m128 swapSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29));
+    __m128 usesSinPoly = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(2)), _mm_setzero_si128()));
+    signBit = _mm_xor_ps(signBit, swapSign);
+
+    x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(0.78515625f)));
+    x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(2.4187564849853515625e-4f)));
+    x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(3.77489497744594108e-8f)));
+    __m128 z = _mm_mul_ps(x, x);
+
+    __m128 cosPoly = _mm_set1_ps(2.443315711809948e-5f);
+    cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(-1.388731625493765e-3f));
+    cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(4.166664568298827e-2f));
+    cosPoly = _mm_mul_ps(_mm_mul_ps(cosPoly, z), z);
+    cosPoly = _mm_sub_ps(cosPoly, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+    cosPoly = _mm_add_ps(cosPoly, _mm_set1_ps(1.0f));
+
+    __m128 sinPoly = _mm_set1_ps(-1.9515295891e-4f);
+    sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(8.3321608736e-3f));
+    sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(-1.6666654611e-1f));
+    sinPoly = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinPoly, z), x), x);
+
+    y = _mm_blendv_ps(cosPoly, sinPoly, usesSinPoly);
+    return _mm_xor_ps(y, signBit);
+}
+
+AQUARIUM_TARGET("sse4.1")
+static void MoveSSE41(const MoveColumns& c, size_t begin, size_t end) {
+    const __m128 left = _mm_set1_ps(-15.0f);
+    const __m128 right = _mm_set1_ps(c.width - 35);
+    const __m128 top = _mm_set1_ps(-20.0f);
+    const __m128 bottom = _mm_set1_ps(c.height - 30);
+    const __m128 minusOne = _mm_set1_ps(-1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128i nemo = _mm_set1_epi32(int(AquariumCreatureType::NewNemoCreature));
+    const __m128i playerSpeed = _mm_set1_epi32(5);
+    const __m128 step = _mm_set1_ps(c.step);
+    const __m128 sineAmplitude = _mm_set1_ps(4.0f * c.step);
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128i speedI = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c.speed + i));
+        __m128 speed = _mm_cvtepi32_ps(speedI);
+        __m128 factor = _mm_mul_ps(_mm_loadu_ps(c.stepFactor + i), step);
+        __m128 dx = _mm_loadu_ps(c.dx + i);
+        __m128 dy = _mm_loadu_ps(c.dy + i);
+
+        // same operation order as the scalar code: (d * speed) * (factor * step)
+        __m128 x = _mm_add_ps(_mm_loadu_ps(c.x + i), _mm_mul_ps(_mm_mul_ps(dx, speed), factor));
+        __m128 yLinear = _mm_add_ps(_mm_loadu_ps(c.y + i), _mm_mul_ps(_mm_mul_ps(dy, speed), factor));
+        __m128 ySine = _mm_add_ps(_mm_loadu_ps(c.y + i), _mm_mul_ps(SinSSE(_mm_mul_ps(x, _mm_set1_ps(0.06f))), sineAmplitude));
+        __m128i typeI = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c.type + i));
+        __m128 y = _mm_blendv_ps(yLinear, ySine, _mm_castsi128_ps(_mm_cmpeq_epi32(typeI, nemo)));
+
+        int facingLeft = _mm_movemask_ps(_mm_cmplt_ps(dx, zero));
+        for (int k = 0; k < 4; ++k) c.flipped[i + k] = (facingLeft >> k) & 1;
+
+        __m128 canReflect = _mm_castsi128_ps(_mm_xor_si128(_mm_cmpeq_epi32(speedI, playerSpeed), _mm_set1_epi32(-1)));
+        __m128 hit = _mm_cmplt_ps(x, left);
+        x = _mm_blendv_ps(x, left, hit);
+        dx = _mm_blendv_ps(dx, _mm_mul_ps(dx, minusOne), _mm_and_ps(hit, canReflect));
+        hit = _mm_cmpgt_ps(x, right);
+        x = _mm_blendv_ps(x, right, hit);
+        dx = _mm_blendv_ps(dx, _mm_mul_ps(dx, minusOne), _mm_and_ps(hit, canReflect));
+        hit = _mm_cmplt_ps(y, top);
+        y = _mm_blendv_ps(y, top, hit);
+        dy = _mm_blendv_ps(dy, _mm_mul_ps(dy, minusOne), _mm_and_ps(hit, canReflect));
+        hit = _mm_cmpgt_ps(y, bottom);
+        y = _mm_blendv_ps(y, bottom, hit);
+        dy = _mm_blendv_ps(dy, _mm_mul_ps(dy, minusOne), _mm_and_ps(hit, canReflect));
+
+        _mm_storeu_ps(c.x + i, x);
+        _mm_storeu_ps(c.y + i, y);
+        _mm_storeu_ps(c.dx + i, dx);
+        _mm_storeu_ps(c.dy + i, dy);
+    }
+    MoveScalar(c, i, end);
+}
+
+
+AQUARIUM_TARGET("avx2")
+static inline __m256 SinAVX2(__m256 x) {
+    const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32(int(0x80000000)));
+    __m256 signBit = _mm256_and_ps(x, signMask);
+    x = _mm256_andnot_ps(signMask, x);
+
+    __m256i j = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(1.27323954473516f))); // 4/pi
+    j = _mm256_and_si256(_mm256_add_epi32(j, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+    __m256 y = _mm256_cvtepi32_ps(j);
+    __m256 swapSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(j, _mm256_set1_epi32(4)), 29));
+    __m256 usesSinPoly = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(j, _mm256_set1_epi32(2)), _mm256_setzero_si256()));
+    signBit = _mm256_xor_ps(signBit, swapSign);
+
+    x = _mm256_sub_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(0.78515625f)));
+    x = _mm256_sub_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(2.4187564849853515625e-4f)));
+    x = _mm256_sub_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(3.77489497744594108e-8f)));
+    __m256 z = _mm256_mul_ps(x, x);
+
+    __m256 cosPoly = _mm256_set1_ps(2.443315711809948e-5f);
+    cosPoly = _mm256_add_ps(_mm256_mul_ps(cosPoly, z), _mm256_set1_ps(-1.388731625493765e-3f));
+    cosPoly = _mm256_add_ps(_mm256_mul_ps(cosPoly, z), _mm256_set1_ps(4.166664568298827e-2f));
+    cosPoly = _mm256_mul_ps(_mm256_mul_ps(cosPoly, z), z);
+    cosPoly = _mm256_sub_ps(cosPoly, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+    cosPoly = _mm256_add_ps(cosPoly, _mm256_set1_ps(1.0f));
+
+    __m256 sinPoly = _mm256_set1_ps(-1.9515295891e-4f);
+    sinPoly = _mm256_add_ps(_mm256_mul_ps(sinPoly, z), _mm256_set1_ps(8.3321608736e-3f));
+    sinPoly = _mm256_add_ps(_mm256_mul_ps(sinPoly, z), _mm256_set1_ps(-1.6666654611e-1f));
+    sinPoly = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(sinPoly, z), x), x);
+
+    y = _mm256_blendv_ps(cosPoly, sinPoly, usesSinPoly);
+    return _mm256_xor_ps(y, signBit);
+}
+
+AQUARIUM_TARGET("avx2")
+static void MoveAVX2(const MoveColumns& c, size_t begin, size_t end) {
+    const __m256 left = _mm256_set1_ps(-15.0f);
+    const __m256 right = _mm256_set1_ps(c.width - 35);
+    const __m256 top = _mm256_set1_ps(-20.0f);
+    const __m256 bottom = _mm256_set1_ps(c.height - 30);
+    const __m256 minusOne = _mm256_set1_ps(-1.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256i nemo = _mm256_set1_epi32(int(AquariumCreatureType::NewNemoCreature));
+    const __m256i playerSpeed = _mm256_set1_epi32(5);
+    const __m256 step = _mm256_set1_ps(c.step);
+    const __m256 sineAmplitude = _mm256_set1_ps(4.0f * c.step);
+
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256i speedI = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c.speed + i));
+        __m256 speed = _mm256_cvtepi32_ps(speedI);
+        __m256 factor = _mm256_mul_ps(_mm256_loadu_ps(c.stepFactor + i), step);
+        __m256 dx = _mm256_loadu_ps(c.dx + i);
+        __m256 dy = _mm256_loadu_ps(c.dy + i);
+
+        // same operation order as the scalar code: (d * speed) * (factor * step)
+        __m256 x = _mm256_add_ps(_mm256_loadu_ps(c.x + i), _mm256_mul_ps(_mm256_mul_ps(dx, speed), factor));
+        __m256 yLinear = _mm256_add_ps(_mm256_loadu_ps(c.y + i), _mm256_mul_ps(_mm256_mul_ps(dy, speed), factor));
+        __m256 ySine = _mm256_add_ps(_mm256_loadu_ps(c.y + i), _mm256_mul_ps(SinAVX2(_mm256_mul_ps(x, _mm256_set1_ps(0.06f))), sineAmplitude));
+        __m256i typeI = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c.type + i));
+        __m256 y = _mm256_blendv_ps(yLinear, ySine, _mm256_castsi256_ps(_mm256_cmpeq_epi32(typeI, nemo)));
+
+        int facingLeft = _mm256_movemask_ps(_mm256_cmp_ps(dx, zero, _CMP_LT_OQ));
+        for (int k = 0; k < 8; ++k) c.flipped[i + k] = (facingLeft >> k) & 1;
+
+        __m256 canReflect = _mm256_castsi256_ps(_mm256_xor_si256(_mm256_cmpeq_epi32(speedI, playerSpeed), _mm256_set1_epi32(-1)));
+        __m256 hit = _mm256_cmp_ps(x, left, _CMP_LT_OQ);
+        x = _mm256_blendv_ps(x, left, hit);
+        dx = _mm256_blendv_ps(dx, _mm256_mul_ps(dx, minusOne), _mm256_and_ps(hit, canReflect));
+        hit = _mm256_cmp_ps(x, right, _CMP_GT_OQ);
+        x = _mm256_blendv_ps(x, right, hit);
+        dx = _mm256_blendv_ps(dx, _mm256_mul_ps(dx, minusOne), _mm256_and_ps(hit, canReflect));
+        hit = _mm256_cmp_ps(y, top, _CMP_LT_OQ);
+        y = _mm256_blendv_ps(y, top, hit);
+        dy = _mm256_blendv_ps(dy, _mm256_mul_ps(dy, minusOne), _mm256_and_ps(hit, canReflect));
+        hit = _mm256_cmp_ps(y, bottom, _CMP_GT_OQ);
+        y = _mm256_blendv_ps(y, bottom, hit);
+        dy = _mm256_blendv_ps(dy, _mm256_mul_ps(dy, minusOne), _mm256_and_ps(hit, canReflect));
+
+        _mm256_storeu_ps(c.x + i, x);
+        _mm256_storeu_ps(c.y + i, y);
+        _mm256_storeu_ps(c.dx + i, dx);
+        _mm256_storeu_ps(c.dy + i, dy);
+    }
+    MoveScalar(c, i, end);
+}
+
+static bool CpuHasSSE41() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+#else
+    return __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+static bool CpuHasAVX2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    bool osSavesYmm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 0x6) == 0x6);
+    __cpuidex(info, 7, 0);
+    return osSavesYmm && (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // AQUARIUM_X86
+
+
+std::vector<MoveKernelInfo> AvailableMoveKernels() {
+    std::vector<MoveKernelInfo> kernels;
+    kernels.push_back({"scalar", MoveScalar, 1});
+#ifdef AQUARIUM_X86
+    if (CpuHasSSE41()) kernels.push_back({"sse4.1", MoveSSE41, 4});
+    if (CpuHasAVX2()) kernels.push_back({"avx2", MoveAVX2, 8});
+#endif
+    return kernels;
+}
+
+const MoveKernelInfo& SelectMoveKernel() {
+    static const MoveKernelInfo selected = [](){
+        MoveKernelInfo widest = AvailableMoveKernels().back();
+        ofLogNotice() << "Creature movement kernel: " << widest.name;
+        return widest;
+    }();
+    return selected;
+}
+
+
+bool CheckMoveKernels(size_t count, int ticks, float step) {
+    CreatureStore reference;
+    reference.setBounds(1004, 748);
+    Random random(1, RandomStream::Spawn);
+    for (size_t i = 0; i < count; ++i) {
+        reference.Spawn(AquariumCreatureType(i % kAquariumCreatureTypeCount), random.Below(1024), random.Below(768), 1 + random.Below(25));
+    }
+
+    bool passed = true;
+    for (const MoveKernelInfo& kernel : AvailableMoveKernels()) {
+        CreatureStore start = reference;
+        double maxError = 0;
+        size_t exactRows = 0;
+        size_t directionMismatches = 0;
+        for (int t = 0; t < ticks; ++t) {
+            // both sides start every tick from the reference state, so the error doesn't compound
+            CreatureStore candidate = start;
+            start.MoveAllReference(step);
+            candidate.MoveAllWith(kernel.kernel, step);
+            for (size_t i = 0; i < count; ++i) {
+                double error = std::max(std::abs(double(start.x[i]) - candidate.x[i]), std::abs(double(start.y[i]) - candidate.y[i]));
+                maxError = std::max(maxError, error);
+                if (error == 0) ++exactRows;
+                if (start.dx[i] != candidate.dx[i] || start.dy[i] != candidate.dy[i] || start.flipped[i] != candidate.flipped[i]) {
+                    ++directionMismatches;
+                }
+            }
+        }
+        // positions may drift by rounding (bigger fish were integrated in double, the sine is a polynomial),
+        // a direction can only differ when that rounding lands right on a margin
+        bool ok = maxError <= 1e-3 && directionMismatches * 10000 <= count * size_t(ticks);
+        ofLogNotice() << "kernel " << kernel.name << " (" << kernel.lanes << " lanes): max position error " << maxError
+                      << ", bit exact rows " << (100.0 * exactRows / (count * ticks)) << "%, direction mismatches "
+                      << directionMismatches << (ok ? "  OK" : "  FAILED");
+        passed = passed && ok;
+    }
+    return passed;
+}
+
+
+bool BenchmarkParallelMove(int maxThreads, int ticks) {
+    if (maxThreads <= 0) {
+        maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    bool deterministic = true;
+    for (size_t count : {size_t(10000), size_t(100000), size_t(1000000)}) {
+        CreatureStore start;
+        start.setBounds(1004, 748);
+        start.Reserve(count);
+        Random random(1, RandomStream::Spawn);
+        for (size_t i = 0; i < count; ++i) {
+            start.Spawn(AquariumCreatureType(i % kAquariumCreatureTypeCount), random.Below(1024), random.Below(768), 1 + random.Below(25));
+        }
+
+        CreatureStore singleThreaded;
+        double singleMs = 0;
+        for (int threads = 1; threads <= maxThreads; ++threads) {
+            ThreadPool pool(threads);
+            CreatureStore store = start;
+            auto begin = std::chrono::steady_clock::now();
+            for (int t = 0; t < ticks; ++t) {
+                store.MoveAllParallel(pool, 1.0f / 6.0f);
+            }
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count() / ticks;
+
+            bool same = true;
+            if (threads == 1) {
+                singleThreaded = store;
+                singleMs = ms;
+            } else {
+                same = std::memcmp(store.x.data(), singleThreaded.x.data(), count * sizeof(float)) == 0
+                    && std::memcmp(store.y.data(), singleThreaded.y.data(), count * sizeof(float)) == 0;
+            }
+            deterministic = deterministic && same;
+            ofLogNotice() << count << " creatures, " << threads << " threads: " << ms << " ms/tick, speedup "
+                          << singleMs / ms << (same ? "" : "  RESULT DIFFERS FROM 1 THREAD");
+        }
+    }
+    return deterministic;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "CreatureStore.h"
+
+
+// Raw column pointers a movement kernel works on
+struct MoveColumns {
+    float* x;
+    float* y;
+    float* dx;
+    float* dy;
+    const int* speed;
+    const float* stepFactor; // speed multiplier of this tick (0.5 bigger fish, 3 fast fish, shark boost...)
+    const AquariumCreatureType* type;
+    uint8_t* flipped;
+    float width;
+    float height;
+    float step; // how much of a full movement step this tick covers
+};
+
+// Integrates rows [begin, end): x += dx*speed*factor*step, y the same except NewNemo swims the sine pattern,
+// then the -15/-35/-20/-30 margin bounce. Every species goes through the same branch free math
+typedef void (*MoveKernel)(const MoveColumns& columns, size_t begin, size_t end);
+
+struct MoveKernelInfo {
+    const char* name;
+    MoveKernel kernel;
+    int lanes;
+};
+
+// Widest kernel the cpu we are running on supports (AVX2 > SSE4.1 > scalar), picked once
+const MoveKernelInfo& SelectMoveKernel();
+// Every kernel the cpu supports, scalar first
+std::vector<MoveKernelInfo> AvailableMoveKernels();
+
+// Runs a random population through CreatureStore::Move (the per species reference) and through every
+// available kernel, and reports how far apart they end up. Used by --check-kernels.
+// The default step is the one the game uses at 60 ticks per second
+bool CheckMoveKernels(size_t count = 100000, int ticks = 200, float step = 1.0f / 6.0f);
+
+// MoveAllParallel at 10k, 100k and 1M creatures with 1 to maxThreads threads (0: every hardware thread).
+// Logs ms per tick and speedup, and fails if any thread count ends up with different positions than 1 thread.
+// Used by --bench-threads
+bool BenchmarkParallelMove(int maxThreads = 0, int ticks = 100);
@@ -0,0 +1,91 @@
+#include "Profiler.h"
+#include <algorithm>
+#include "ofMain.h"
+
+
+Profiler::Sample Profiler::s_samples[Profiler::kCapacity];
+
+const char* ProfilePhaseToString(ProfilePhase phase) {
+    switch (phase) {
+        case ProfilePhase::Frame: return "frame";
+        case ProfilePhase::SceneUpdate: return "update";
+        case ProfilePhase::Movement: return "movement";
+        case ProfilePhase::Collisions: return "collisions";
+        case ProfilePhase::Repopulate: return "repopulate";
+        case ProfilePhase::Background: return "background";
+        case ProfilePhase::AquariumDraw: return "aquarium draw";
+        case ProfilePhase::Hud: return "hud";
+        case ProfilePhase::InputLatency: return "input latency";
+        default: return "?";
+    }
+}
+
+void Profiler::Record(ProfilePhase phase, uint64_t nanoseconds) {
+    uint64_t index = s_next.fetch_add(1, std::memory_order_relaxed);
+    Sample& sample = s_samples[index & (kCapacity - 1)];
+    sample.sequence.store(0, std::memory_order_relaxed); // being written
+    std::atomic_thread_fence(std::memory_order_release);
+    sample.phase = phase;
+    sample.nanoseconds = uint32_t(std::min<uint64_t>(nanoseconds, UINT32_MAX));
+    sample.sequence.store(index + 1, std::memory_order_release);
+}
+
+size_t Profiler::Collect(ProfilePhase phase, float* out, size_t max) {
+    uint64_t end = s_next.load(std::memory_order_acquire);
+    uint64_t begin = end > kCapacity ? end - kCapacity : 0;
+    size_t count = 0;
+    for (uint64_t index = end; index > begin && count < max; --index) {
+        const Sample& sample = s_samples[(index - 1) & (kCapacity - 1)];
+        if (sample.sequence.load(std::memory_order_acquire) != index) continue; // overwritten or mid write
+        ProfilePhase samplePhase = sample.phase;
+        float ms = sample.nanoseconds / 1e6f;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sample.sequence.load(std::memory_order_relaxed) != index) continue;
+        if (samplePhase == phase) {
+            out[count++] = ms;
+        }
+    }
+    return count;
+}
+
+float Profiler::Percentile(ProfilePhase phase, float percentile) {
+    float window[kWindow]; // on the stack, so any thread can ask
+    size_t count = Collect(phase, window, kWindow);
+    if (count == 0) return 0.0f;
+    size_t rank = std::min(count - 1, size_t(percentile * count));
+    std::nth_element(window, window + rank, window + count);
+    return window[rank];
+}
+
+void Profiler::DrawOverlay(float x, float y, int creatureCount, int drawCalls) {
+    const float graphWidth = 240;
+    const float graphHeight = 50;
+    const float msPerGraph = 50.0f; // top of the graph, a 20 fps frame
+
+    // frame time graph, newest sample on the right, 16.7 ms line for reference
+    float frames[kWindow];
+    size_t count = Collect(ProfilePhase::Frame, frames, kWindow);
+    ofSetColor(0, 0, 0, 160);
+    ofDrawRectangle(x, y, graphWidth, graphHeight + 12 * (int(ProfilePhase::Count) + 2));
+    ofSetColor(ofColor::yellow);
+    float budgetY = y + graphHeight - graphHeight * (16.7f / msPerGraph);
+    ofDrawLine(x, budgetY, x + graphWidth, budgetY);
+    ofMesh graph;
+    graph.setMode(OF_PRIMITIVE_LINE_STRIP);
+    for (size_t i = 0; i < count; ++i) {
+        float height = std::min(frames[i] / msPerGraph, 1.0f) * graphHeight;
+        graph.addVertex(glm::vec3(x + graphWidth - i, y + graphHeight - height, 0));
+    }
+    ofSetColor(ofColor::green);
+    graph.draw();
+
+    ofSetColor(ofColor::white);
+    float line = y + graphHeight + 12;
+    for (int p = 0; p < int(ProfilePhase::Count); ++p) {
+        ProfilePhase phase = ProfilePhase(p);
+        ofDrawBitmapString(ofToString(ProfilePhaseToString(phase)) + ": p50 " + ofToString(Percentile(phase, 0.5f), 2)
+                           + " p99 " + ofToString(Percentile(phase, 0.99f), 2) + " ms", x + 4, line);
+        line += 12;
+    }
+    ofDrawBitmapString("creatures " + ofToString(creatureCount) + "  draws " + ofToString(drawCalls), x + 4, line);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+
+// Phases of a frame the profiler overlay breaks the time into
+enum class ProfilePhase : uint8_t {
+    Frame,          // real time between frames
+    SceneUpdate,    // AquariumGameScene::Update, every tick of the frame
+    Movement,       // Aquarium::update minus repopulation
+    Collisions,     // collision + power up detection and handling the events
+    Repopulate,
+    Background,
+    AquariumDraw,
+    Hud,
+    InputLatency,   // key callback until the frame showing its effect was drawn (AquariumGameScene::PresentInput)
+    Count
+};
+const char* ProfilePhaseToString(ProfilePhase phase);
+
+// Collects phase timings into a fixed ring. Recording is lock free (a fetch_add for the slot and a sequence
+// number per slot so the overlay never reads a half written sample), older samples get overwritten.
+// While disabled a ScopedPhaseTimer is one relaxed load and a branch
+class Profiler {
+public:
+    static bool IsEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void SetEnabled(bool enabled) { s_enabled.store(enabled, std::memory_order_relaxed); }
+    static void Toggle() { SetEnabled(!IsEnabled()); }
+
+    static void Record(ProfilePhase phase, uint64_t nanoseconds);
+
+    // percentile (0..1) of the phase over its last samples, in milliseconds. 0 without samples
+    static float Percentile(ProfilePhase phase, float percentile);
+    // overlay next to the HUD panel: frame time graph, p50/p99 of every phase, creature and draw counts
+    static void DrawOverlay(float x, float y, int creatureCount, int drawCalls);
+
+private:
+    struct Sample {
+        std::atomic<uint64_t> sequence{0}; // index + 1 of the sample in the slot, 0 while empty
+        ProfilePhase phase;
+        uint32_t nanoseconds;
+    };
+    static constexpr size_t kCapacity = 8192; // power of two
+    static constexpr size_t kWindow = 240;    // newest samples of a phase the percentiles and the graph look at
+    static inline std::atomic<bool> s_enabled{false};
+    static inline std::atomic<uint64_t> s_next{0};
+    static Sample s_samples[kCapacity];
+
+    // the newest samples of one phase, newest first; returns how many were copied
+    static size_t Collect(ProfilePhase phase, float* out, size_t max);
+};
+
+class ScopedPhaseTimer {
+public:
+    explicit ScopedPhaseTimer(ProfilePhase phase) : m_phase(phase), m_active(Profiler::IsEnabled()) {
+        if (m_active) m_start = std::chrono::steady_clock::now();
+    }
+    ~ScopedPhaseTimer() {
+        if (m_active) {
+            auto elapsed = std::chrono::steady_clock::now() - m_start;
+            Profiler::Record(m_phase, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+    }
+    ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+    ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+
+private:
+    ProfilePhase m_phase;
+    bool m_active;
+    std::chrono::steady_clock::time_point m_start;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+
+// Independent random streams of an aquarium, derived from its one seed
+enum class RandomStream : uint64_t {
+    Spawn,      // creature positions and speeds
+    PowerUps,   // power up positions
+    Creatures,  // seeds the per creature streams of the CreatureStore (directions, shark timers)
+    Chunks,     // + chunk index, parallel work draws from these so it doesn't matter which thread runs a chunk
+};
+
+// xoshiro256** (Blackman & Vigna): 32 bytes of state, a handful of shifts and rotates per number.
+// Not thread safe on purpose, each subsystem/chunk owns its own instance
+class Random {
+public:
+    Random() : Random(1) {}
+    // the state is filled from seed and stream through splitmix64, so nearby seeds/streams still start far apart
+    explicit Random(uint64_t seed, uint64_t stream = 0) {
+        uint64_t x = seed ^ (stream * 0xD1B54A32D192ED03ull);
+        for (uint64_t& word : m_state) {
+            word = SplitMix64(x);
+        }
+    }
+    Random(uint64_t seed, RandomStream stream, uint64_t index = 0) : Random(seed, uint64_t(stream) + index) {}
+
+    uint64_t Next() {
+        const uint64_t result = Rotl(m_state[1] * 5, 7) * 9;
+        const uint64_t t = m_state[1] << 17;
+        m_state[2] ^= m_state[0];
+        m_state[3] ^= m_state[1];
+        m_state[1] ^= m_state[2];
+        m_state[0] ^= m_state[3];
+        m_state[2] ^= t;
+        m_state[3] = Rotl(m_state[3], 45);
+        return result;
+    }
+
+    // [0, bound) without a division (multiply and keep the high half)
+    uint32_t Below(uint32_t bound) { return uint32_t(((Next() >> 32) * bound) >> 32); }
+    // [low, high)
+    float Range(float low, float high) { return low + (high - low) * ((Next() >> 40) * (1.0f / 16777216.0f)); }
+
+    static uint64_t SplitMix64(uint64_t& x) {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+private:
+    static uint64_t Rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    uint64_t m_state[4];
+};
@@ -0,0 +1,64 @@
+#include "Snapshot.h"
+#include <cstring>
+#include <fstream>
+#include "ofMain.h"
+
+
+SnapshotWriter::SnapshotWriter() {
+    m_bytes.resize(sizeof(SnapshotHeader)); // filled in by Save()
+}
+
+void SnapshotWriter::Append(const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    m_bytes.insert(m_bytes.end(), bytes, bytes + size);
+}
+
+void SnapshotWriter::Align() {
+    m_bytes.resize((m_bytes.size() + 15) & ~size_t(15), 0);
+}
+
+bool SnapshotWriter::Save(const std::string& path) {
+    SnapshotHeader header;
+    std::memcpy(header.magic, "AQSS", 4);
+    header.version = kSnapshotVersion;
+    header.bytes = m_bytes.size();
+    std::memcpy(m_bytes.data(), &header, sizeof(header));
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(m_bytes.data()), m_bytes.size());
+    if (!out) {
+        ofLogError() << "Failed to write snapshot " << path;
+        return false;
+    }
+    return true;
+}
+
+
+bool SnapshotReader::Open(const std::string& path) {
+    m_good = false;
+    m_offset = 0;
+    if (!m_file.Open(path) || m_file.size() < sizeof(SnapshotHeader)) {
+        ofLogError() << "Can't open snapshot " << path;
+        return false;
+    }
+    SnapshotHeader header;
+    std::memcpy(&header, m_file.data(), sizeof(header));
+    if (std::memcmp(header.magic, "AQSS", 4) != 0 || header.version != kSnapshotVersion) {
+        ofLogError() << "Snapshot " << path << " has the wrong format or version";
+        return false;
+    }
+    if (header.bytes != m_file.size()) {
+        ofLogError() << "Snapshot " << path << " is truncated";
+        return false;
+    }
+    m_offset = sizeof(header);
+    m_good = true;
+    return true;
+}
+
+bool SnapshotReader::Take(void* out, size_t size) {
+    if (!m_good || m_offset + size > m_file.size()) return this->Fail();
+    std::memcpy(out, m_file.data() + m_offset, size);
+    m_offset += size;
+    return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "AssetPack.h"
+
+
+// On disk layout of a snapshot (little endian):
+//   SnapshotHeader
+//   whatever each class writes in its Save(), read back in the same order by its Load().
+//   Arrays are a uint64 count followed by the raw elements aligned to 16 bytes, so loading a column out of the
+//   mapped file is a single copy no matter how many creatures there are
+struct SnapshotHeader {
+    char magic[4];      // "AQSS"
+    uint32_t version;
+    uint64_t bytes;     // whole file, a truncated snapshot is rejected before anything is restored
+};
+
+static_assert(sizeof(SnapshotHeader) == 16, "snapshot header layout changed");
+
+const uint32_t kSnapshotVersion = 1;
+
+
+class SnapshotWriter {
+public:
+    SnapshotWriter();
+
+    template <typename T>
+    void Write(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values go in a snapshot");
+        this->Append(&value, sizeof(T));
+    }
+    template <typename T>
+    void WriteArray(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values go in a snapshot");
+        this->Write<uint64_t>(values.size());
+        this->Align();
+        this->Append(values.data(), values.size() * sizeof(T));
+    }
+    bool Save(const std::string& path);
+
+private:
+    void Append(const void* data, size_t size);
+    void Align();
+    std::vector<unsigned char> m_bytes;
+};
+
+
+// Reads a snapshot straight from the mapped file. Any read past the end (or a wrong count) marks the
+// reader as failed, callers check isGood() once they're done
+class SnapshotReader {
+public:
+    bool Open(const std::string& path);
+    bool isGood() const { return m_good; }
+
+    template <typename T>
+    bool Read(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values go in a snapshot");
+        return this->Take(&value, sizeof(T));
+    }
+    template <typename T>
+    bool ReadArray(std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values go in a snapshot");
+        uint64_t count = 0;
+        if (!this->Read(count)) return false;
+        this->Align();
+        if (m_offset > m_file.size() || count > (m_file.size() - m_offset) / sizeof(T)) return this->Fail();
+        const T* first = reinterpret_cast<const T*>(m_file.data() + m_offset);
+        values.assign(first, first + count);
+        m_offset += count * sizeof(T);
+        return true;
+    }
+    bool Fail() { m_good = false; return false; }
+
+private:
+    bool Take(void* out, size_t size);
+    void Align() { m_offset = (m_offset + 15) & ~size_t(15); }
+
+    MappedFile m_file;
+    size_t m_offset = 0;
+    bool m_good = false;
+};
@@ -0,0 +1,158 @@
+#include "SpatialHash.h"
+#include "Snapshot.h"
+#include <algorithm>
+#include <cmath>
+
+
+// one extra cell on each side so the -15/-20 margins still land inside the grid
+int SpatialHash::CellX(float x) const {
+    int cx = int(std::floor(x / m_cellSize)) + 1;
+    return std::min(std::max(cx, 0), m_cols - 1);
+}
+
+int SpatialHash::CellY(float y) const {
+    int cy = int(std::floor(y / m_cellSize)) + 1;
+    return std::min(std::max(cy, 0), m_rows - 1);
+}
+
+void SpatialHash::Resize(float width, float height, const CreatureStore& store) {
+    m_cols = std::max(1, int(std::ceil(width / m_cellSize)) + 2);
+    m_rows = std::max(1, int(std::ceil(height / m_cellSize)) + 2);
+    m_cells.assign(m_cols * m_rows, std::vector<uint32_t>());
+    this->Rebuild(store);
+}
+
+void SpatialHash::Rebuild(const CreatureStore& store) {
+    this->Clear();
+    for (size_t row = 0; row < store.size(); ++row) {
+        this->Insert(row, store.x[row], store.y[row], store.radius[row]);
+    }
+}
+
+void SpatialHash::Reserve(size_t rows) {
+    m_cellOf.reserve(rows);
+    m_slotOf.reserve(rows);
+}
+
+void SpatialHash::Link(size_t row, int cell) {
+    m_cellOf[row] = cell;
+    m_slotOf[row] = m_cells[cell].size();
+    m_cells[cell].push_back(row);
+}
+
+// swap and pop inside the cell, the row that took the slot gets its new slot index
+void SpatialHash::Unlink(size_t row) {
+    std::vector<uint32_t>& cell = m_cells[m_cellOf[row]];
+    uint32_t slot = m_slotOf[row];
+    cell[slot] = cell.back();
+    m_slotOf[cell[slot]] = slot;
+    cell.pop_back();
+}
+
+void SpatialHash::Insert(size_t row, float x, float y, float radius) {
+    if (row >= m_cellOf.size()) {
+        m_cellOf.resize(row + 1, -1);
+        m_slotOf.resize(row + 1, 0);
+    }
+    m_maxRadius = std::max(m_maxRadius, radius);
+    this->Link(row, this->CellY(y) * m_cols + this->CellX(x));
+}
+
+void SpatialHash::Remove(size_t row) {
+    if (row >= m_cellOf.size()) return;
+    this->Unlink(row);
+    const size_t last = m_cellOf.size() - 1;
+    if (row != last) {
+        m_cellOf[row] = m_cellOf[last];
+        m_slotOf[row] = m_slotOf[last];
+        m_cells[m_cellOf[row]][m_slotOf[row]] = row;
+    }
+    m_cellOf.pop_back();
+    m_slotOf.pop_back();
+}
+
+void SpatialHash::Clear() {
+    for (std::vector<uint32_t>& cell : m_cells) {
+        cell.clear(); // keeps the capacity for the next level
+    }
+    m_cellOf.clear();
+    m_slotOf.clear();
+    m_maxRadius = 0.0f;
+}
+
+void SpatialHash::Update(const CreatureStore& store) {
+    const size_t count = std::min(store.size(), m_cellOf.size());
+    for (size_t row = 0; row < count; ++row) {
+        int cell = this->CellY(store.y[row]) * m_cols + this->CellX(store.x[row]);
+        if (cell != m_cellOf[row]) {
+            this->Unlink(row);
+            this->Link(row, cell);
+        }
+    }
+}
+
+void SpatialHash::Query(float x, float y, float radius, std::vector<size_t>& out) const {
+    const int x0 = this->CellX(x - radius), x1 = this->CellX(x + radius);
+    const int y0 = this->CellY(y - radius), y1 = this->CellY(y + radius);
+    for (int cy = y0; cy <= y1; ++cy) {
+        for (int cx = x0; cx <= x1; ++cx) {
+            const std::vector<uint32_t>& cell = m_cells[cy * m_cols + cx];
+            out.insert(out.end(), cell.begin(), cell.end());
+        }
+    }
+}
+
+size_t SpatialHash::getMemoryBytes() const {
+    size_t bytes = m_cells.capacity() * sizeof(std::vector<uint32_t>)
+                 + m_cellOf.capacity() * sizeof(int) + m_slotOf.capacity() * sizeof(uint32_t);
+    for (const std::vector<uint32_t>& cell : m_cells) {
+        bytes += cell.capacity() * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+void SpatialHash::Save(SnapshotWriter& out) const {
+    out.Write(m_cols);
+    out.Write(m_rows);
+    out.Write(m_maxRadius);
+    out.WriteArray(m_cellOf);
+    out.WriteArray(m_slotOf);
+}
+
+bool SpatialHash::Load(SnapshotReader& in, size_t rows) {
+    int cols = 0;
+    int cellRows = 0;
+    in.Read(cols);
+    in.Read(cellRows);
+    in.Read(m_maxRadius);
+    in.ReadArray(m_cellOf);
+    in.ReadArray(m_slotOf);
+    if (!in.isGood() || cols != m_cols || cellRows != m_rows || m_cellOf.size() != rows || m_slotOf.size() != rows
+        || !std::isfinite(m_maxRadius)) {
+        this->Clear();
+        return in.Fail();
+    }
+
+    // size every cell first, then drop each row in its saved slot. A slot still holding the marker is free,
+    // with as many slots as rows a duplicate is caught when it lands and no slot can be left over
+    const uint32_t kFree = UINT32_MAX;
+    for (std::vector<uint32_t>& cell : m_cells) {
+        cell.clear();
+    }
+    for (int cell : m_cellOf) {
+        if (cell < 0 || cell >= int(m_cells.size())) {
+            this->Clear();
+            return in.Fail();
+        }
+        m_cells[cell].push_back(kFree);
+    }
+    for (size_t row = 0; row < rows; ++row) {
+        std::vector<uint32_t>& cell = m_cells[m_cellOf[row]];
+        if (m_slotOf[row] >= cell.size() || cell[m_slotOf[row]] != kFree) {
+            this->Clear();
+            return in.Fail();
+        }
+        cell[m_slotOf[row]] = row;
+    }
+    return true;
+}
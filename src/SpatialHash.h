@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "CreatureStore.h"
+
+
+// Uniform grid over the aquarium used as the collision broadphase.
+// Each cell keeps the store rows whose position falls in it, and every row remembers its cell and its
+// slot inside it, so moving a creature to another cell is O(1) and a query only touches nearby cells.
+// Positions outside the bounds are clamped into the border cells.
+class SpatialHash {
+public:
+    explicit SpatialHash(float cellSize = 64.0f) : m_cellSize(cellSize) {}
+
+    // re-grids for new bounds and reinserts every row of the store
+    void Resize(float width, float height, const CreatureStore& store);
+    void Rebuild(const CreatureStore& store);
+
+    void Reserve(size_t rows);
+    void Insert(size_t row, float x, float y, float radius);
+    // same swap and pop as CreatureStore::Remove, the last row's entry is renamed to row
+    void Remove(size_t row);
+    void Clear();
+    // moves the rows that changed cell since the last call, call after the store moved
+    void Update(const CreatureStore& store);
+
+    // appends every row in the cells touched by the square around (x, y), candidates only
+    void Query(float x, float y, float radius, std::vector<size_t>& out) const;
+
+    // largest collision radius inserted since the last Clear, queries have to reach this far
+    float getMaxRadius() const { return m_maxRadius; }
+    size_t getMemoryBytes() const;
+    // the cell and slot of every row, so a loaded grid hands out candidates in the same order as the saved one.
+    // Load expects the grid to be sized for the same bounds already, and the store it indexes to have rows rows.
+    // Every row has to take a slot of its own, a grid that fails that is left empty
+    void Save(SnapshotWriter& out) const;
+    bool Load(SnapshotReader& in, size_t rows);
+
+private:
+    int CellX(float x) const;
+    int CellY(float y) const;
+    void Link(size_t row, int cell);
+    void Unlink(size_t row);
+
+    float m_cellSize;
+    int m_cols = 1;
+    int m_rows = 1;
+    float m_maxRadius = 0.0f;
+    std::vector<std::vector<uint32_t>> m_cells = std::vector<std::vector<uint32_t>>(1);
+    std::vector<int> m_cellOf;      // per row
+    std::vector<uint32_t> m_slotOf; // per row, index inside its cell
+};
@@ -0,0 +1,98 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+
+ThreadPool::ThreadPool(int threads) {
+    if (threads <= 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (int i = 0; i < threads; ++i) {
+        m_queues.push_back(std::make_unique<Queue>());
+    }
+    for (int i = 1; i < threads; ++i) {
+        m_workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+// own deque from the front, everybody else's from the back
+bool ThreadPool::PopOrSteal(int self, Chunk& chunk) {
+    const int count = this->getThreadCount();
+    for (int k = 0; k < count; ++k) {
+        const int victim = (self + k) % count;
+        Queue& queue = *m_queues[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.chunks.empty()) continue;
+        if (victim == self) {
+            chunk = queue.chunks.front();
+            queue.chunks.pop_front();
+        } else {
+            chunk = queue.chunks.back();
+            queue.chunks.pop_back();
+        }
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::RunChunks(int self) {
+    Chunk chunk;
+    while (this->PopOrSteal(self, chunk)) {
+        (*m_job)(chunk.begin, chunk.end);
+        if (m_remaining.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_finished.notify_all();
+        }
+    }
+}
+
+void ThreadPool::WorkerLoop(int index) {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+            if (m_stop) return;
+            seen = m_generation;
+        }
+        this->RunChunks(index);
+    }
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t chunkSize, const std::function<void(size_t, size_t)>& fn) {
+    if (count == 0) return;
+    chunkSize = std::max<size_t>(1, chunkSize);
+    if (count <= chunkSize || m_workers.empty()) {
+        fn(0, count);
+        return;
+    }
+
+    const size_t chunks = (count + chunkSize - 1) / chunkSize;
+    m_job = &fn;
+    m_remaining = chunks;
+    for (size_t i = 0; i < chunks; ++i) {
+        Queue& queue = *m_queues[i % m_queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.chunks.push_back({i * chunkSize, std::min(count, (i + 1) * chunkSize)});
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    this->RunChunks(0);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_finished.wait(lock, [&] { return m_remaining.load() == 0; });
+    m_job = nullptr;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// Fixed set of worker threads for data parallel loops.
+// ParallelFor deals the chunks round robin into one deque per thread; each thread works through its own
+// deque from the front and, once it runs dry, steals from the back of the others. The calling thread
+// takes part as thread 0, so a pool of N threads spawns N-1 workers
+class ThreadPool {
+public:
+    explicit ThreadPool(int threads = 0); // 0: one per hardware thread
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int getThreadCount() const { return int(m_queues.size()); }
+
+    // Runs fn(begin, end) over [0, count) in chunks of chunkSize and returns once every chunk is done.
+    // A single chunk runs inline without waking anyone
+    void ParallelFor(size_t count, size_t chunkSize, const std::function<void(size_t, size_t)>& fn);
+
+private:
+    struct Chunk {
+        size_t begin;
+        size_t end;
+    };
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Chunk> chunks;
+    };
+
+    bool PopOrSteal(int self, Chunk& chunk);
+    void RunChunks(int self);
+    void WorkerLoop(int index);
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_finished;
+    uint64_t m_generation = 0;
+    bool m_stop = false;
+
+    const std::function<void(size_t, size_t)>* m_job = nullptr;
+    std::atomic<size_t> m_remaining{0};
+};
@@ -0,0 +1,101 @@
+#include "Trace.h"
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include "AssetPack.h"
+#include "ofMain.h"
+
+
+Trace::Slot Trace::s_slots[Trace::kCapacity];
+
+const char* TraceEventToString(TraceEvent event) {
+    switch (event) {
+        case TraceEvent::Tick: return "tick";
+        case TraceEvent::Collision: return "collision";
+        case TraceEvent::CreatureRemoved: return "creature removed";
+        case TraceEvent::PlayerDamaged: return "player damaged";
+        case TraceEvent::PowerUp: return "power up";
+        case TraceEvent::LevelCompleted: return "level completed";
+        case TraceEvent::Repopulate: return "repopulate";
+        case TraceEvent::Spawn: return "spawn";
+        case TraceEvent::GameOver: return "game over";
+        case TraceEvent::SnapshotLoaded: return "snapshot loaded";
+        default: return "?";
+    }
+}
+
+void Trace::SetEnabled(bool enabled) {
+    if (enabled && !IsEnabled()) {
+        s_start = std::chrono::steady_clock::now();
+    }
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Trace::Record(TraceEvent event, int32_t value, float a0, float a1, float a2, float a3) {
+    uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_start).count();
+    uint64_t index = s_next.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = s_slots[index & (kCapacity - 1)];
+    slot.sequence.store(0, std::memory_order_relaxed); // being written
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.record = TraceRecord{nanoseconds, event, 0, value, {a0, a1, a2, a3}};
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+bool Trace::Dump(const std::string& path) {
+    uint64_t end = s_next.load(std::memory_order_acquire);
+    uint64_t begin = end > kCapacity ? end - kCapacity : 0;
+    std::vector<TraceRecord> records;
+    records.reserve(end - begin);
+    for (uint64_t index = begin + 1; index <= end; ++index) {
+        const Slot& slot = s_slots[(index - 1) & (kCapacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != index) continue; // overwritten or mid write
+        TraceRecord record = slot.record;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != index) continue;
+        records.push_back(record);
+    }
+
+    TraceFileHeader header;
+    std::memcpy(header.magic, "AQTR", 4);
+    header.version = kTraceVersion;
+    header.count = records.size();
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(TraceRecord));
+    if (!out) {
+        ofLogError() << "Failed to write the trace " << path;
+        return false;
+    }
+    ofLogNotice() << "Dumped " << records.size() << " trace records to " << path;
+    return true;
+}
+
+bool Trace::Decode(const std::string& path, std::ostream& out) {
+    MappedFile file;
+    if (!file.Open(path) || file.size() < sizeof(TraceFileHeader)) {
+        ofLogError() << "Can't open trace " << path;
+        return false;
+    }
+    TraceFileHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, "AQTR", 4) != 0 || header.version != kTraceVersion) {
+        ofLogError() << "Trace " << path << " has the wrong format or version";
+        return false;
+    }
+    if (header.count > (file.size() - sizeof(header)) / sizeof(TraceRecord)) {
+        ofLogError() << "Trace " << path << " is truncated";
+        return false;
+    }
+
+    out << "microseconds,event,value,arg0,arg1,arg2,arg3\n";
+    for (uint64_t i = 0; i < header.count; ++i) {
+        TraceRecord record;
+        std::memcpy(&record, file.data() + sizeof(header) + i * sizeof(TraceRecord), sizeof(record));
+        out << record.nanoseconds / 1000.0 << ',' << TraceEventToString(record.event) << ',' << record.value;
+        for (float arg : record.args) {
+            out << ',' << arg;
+        }
+        out << '\n';
+    }
+    return true;
+}
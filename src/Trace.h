@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+
+// What a trace record stands for, and what its value/args hold
+enum class TraceEvent : uint16_t {
+    Tick,               // value: tick, args: creature count
+    Collision,          // value: creature slot, args: x, y, creature value, player power
+    CreatureRemoved,    // value: creature slot, args: x, y, type
+    PlayerDamaged,      // value: lives left, args: x, y
+    PowerUp,            // value: power up index, args: lives after picking it
+    LevelCompleted,     // value: level number (Aquarium::getCurrentLevel before it moved on)
+    Repopulate,         // value: creatures spawned
+    Spawn,              // value: count, args: type
+    GameOver,           // value: tick
+    SnapshotLoaded,     // value: tick, args: creature count, milliseconds
+    Count
+};
+const char* TraceEventToString(TraceEvent event);
+
+// On disk layout of a trace dump (little endian): TraceFileHeader, then TraceRecord x count, oldest first
+struct TraceRecord {
+    uint64_t nanoseconds;   // since tracing was turned on
+    TraceEvent event;
+    uint16_t reserved;
+    int32_t value;
+    float args[4];
+};
+
+struct TraceFileHeader {
+    char magic[4];          // "AQTR"
+    uint32_t version;
+    uint64_t count;
+};
+
+static_assert(sizeof(TraceRecord) == 32, "trace record layout changed");
+static_assert(sizeof(TraceFileHeader) == 16, "trace header layout changed");
+
+const uint32_t kTraceVersion = 1;
+
+
+// Binary event trace: records go into a fixed ring (lock free, the same sequence scheme as the Profiler), the
+// oldest ones get overwritten. Nothing is formatted while the game runs, Dump() writes the raw ring and
+// Decode() turns a dump into text offline (--decode-trace). While disabled an AQ_TRACE is a relaxed load
+class Trace {
+public:
+    static bool IsEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void SetEnabled(bool enabled);
+
+    static void Record(TraceEvent event, int32_t value, float a0 = 0, float a1 = 0, float a2 = 0, float a3 = 0);
+    // whatever is still in the ring, oldest first
+    static bool Dump(const std::string& path);
+    static bool Decode(const std::string& path, std::ostream& out);
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence{0}; // index + 1 of the record in the slot, 0 while empty or mid write
+        TraceRecord record;
+    };
+    static constexpr size_t kCapacity = 1 << 16; // power of two, 2 MB
+    static inline std::atomic<bool> s_enabled{false};
+    static inline std::atomic<uint64_t> s_next{0};
+    static inline std::chrono::steady_clock::time_point s_start;
+    static Slot s_slots[kCapacity];
+};
+
+// AQ_TRACE(TraceEvent::Spawn, count, type). -DAQUARIUM_TRACE=0 compiles every trace point out
+#ifndef AQUARIUM_TRACE
+#define AQUARIUM_TRACE 1
+#endif
+#if AQUARIUM_TRACE
+#define AQ_TRACE(...) do { if (Trace::IsEnabled()) Trace::Record(__VA_ARGS__); } while (0)
+#else
+#define AQ_TRACE(...) do {} while (0)
+#endif
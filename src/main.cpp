@@ -1,17 +1,101 @@
 #include "ofMain.h"
 #include "ofApp.h"
+#include "MoveKernels.h"
+#include "Headless.h"
+#include "Benchmarks.h"
+#include "AllocationCounter.h"
 
 //========================================================================
-int main( ){
+int main(int argc, char* argv[]){
 
 	//Use ofGLFWWindowSettings for more options like multi-monitor fullscreen
 	ofGLWindowSettings settings;
 	settings.setSize(1024, 768);
 	settings.windowMode = OF_WINDOW; //can also be OF_FULLSCREEN
 
+	auto app = std::make_shared<ofApp>();
+	HeadlessOptions headless;
+	bool runHeadless = false;
+	for(int i = 1; i < argc; ++i){
+		std::string arg = argv[i];
+		if(arg == "--bake-assets"){
+			// build step, no window needed: bake the sprites and leave
+			std::string packPath = (i + 1 < argc) ? argv[i + 1] : ofToDataPath("sprites.pack");
+			return ofApp::BakeAssets(packPath, 1024, 768) ? 0 : 1;
+		}
+		if(arg == "--check-kernels"){
+			// compares the vector movement kernels against the per species reference, no window needed
+			return CheckMoveKernels() ? 0 : 1;
+		}
+		if(arg == "--bench-threads"){
+			// movement scaling from 1 to N threads, optionally capped by the next argument
+			int maxThreads = (i + 1 < argc) ? std::atoi(argv[i + 1]) : 0;
+			return BenchmarkParallelMove(maxThreads) ? 0 : 1;
+		}
+		if(arg == "--bench"){
+			// hot path microbenchmarks, JSON to the next argument or stdout
+			std::string outputPath = (i + 1 < argc && argv[i + 1][0] != '-') ? argv[i + 1] : "";
+			SetAllocationCounting(true);
+			return RunBenchmarks(outputPath) ? 0 : 1;
+		}
+		if(arg == "--decode-trace" && i + 1 < argc){
+			// a dump of the T key or --trace as CSV on stdout
+			return Trace::Decode(argv[i + 1], std::cout) ? 0 : 1;
+		}
+		if(arg == "--tick-rate" && i + 1 < argc){
+			// simulation ticks per second, the game plays the same at any rate
+			app->tickRate = std::max(1.0, std::atof(argv[++i]));
+			headless.tickRate = app->tickRate;
+		}
+		// --headless: no window, GL or audio, a bot (or --script file) plays as fast as the cpu allows
+		if(arg == "--headless"){
+			runHeadless = true;
+		}
+		if(arg == "--ticks" && i + 1 < argc){
+			headless.maxTicks = std::atoll(argv[++i]);
+		}
+		if(arg == "--levels" && i + 1 < argc){
+			headless.levels = std::atoi(argv[++i]);
+		}
+		if(arg == "--lives" && i + 1 < argc){
+			headless.lives = std::atoi(argv[++i]);
+		}
+		if(arg == "--seed" && i + 1 < argc){
+			// same seed, same spawns and fish behavior (the log prints the seed of every run)
+			headless.seed = app->seed = std::strtoull(argv[++i], nullptr, 10);
+		}
+		if(arg == "--script" && i + 1 < argc){
+			headless.scriptPath = argv[++i];
+		}
+		// --record/--replay: binary input log of a session, replayed at real speed (or as fast as possible with --headless)
+		if(arg == "--record" && i + 1 < argc){
+			headless.recordPath = app->recordPath = argv[++i];
+		}
+		if(arg == "--replay" && i + 1 < argc){
+			headless.replayPath = app->replayPath = argv[++i];
+		}
+		// --snapshot: starts from a saved game (F5 in the window), --save-snapshot: headless runs save where they ended
+		if(arg == "--snapshot" && i + 1 < argc){
+			headless.snapshotPath = app->snapshotPath = argv[++i];
+		}
+		if(arg == "--save-snapshot" && i + 1 < argc){
+			headless.saveSnapshotPath = argv[++i];
+		}
+		if(arg == "--trace" && i + 1 < argc){
+			headless.tracePath = argv[++i];
+		}
+		if(arg == "--no-pack"){
+			app->useAssetPack = false;
+		}
+	}
+
+	if(runHeadless){
+		return RunHeadless(headless);
+	}
+
 	auto window = ofCreateWindow(settings);
 
-	ofRunApp(window, std::make_shared<ofApp>());
+	ofRunApp(window, app);
 	ofRunMainLoop();
 
 }
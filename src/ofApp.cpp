@@ -1,12 +1,36 @@
 #include "ofApp.h"
 
+// Full window images, baked at the default window size
+static const char* kBannerImages[] = {"title.png", "game-over.png", "background.png"};
+
+//--------------------------------------------------------------
+bool ofApp::BakeAssets(const std::string& packPath, int width, int height){
+    AssetPackWriter writer;
+    AquariumSpriteManager(false).getAtlas()->Bake(writer);
+    for(const char* banner : kBannerImages){
+        GameSprite::DescribeStandalone(banner, width, height)->Bake(writer);
+    }
+    if(!writer.Write(packPath)){
+        ofLogError() << "Failed to write asset pack " << packPath;
+        return false;
+    }
+    ofLogNotice() << "Baked asset pack " << packPath;
+    return true;
+}
+
 //--------------------------------------------------------------
 void ofApp::setup(){
+    if(useAssetPack){
+        auto pack = std::make_shared<AssetPack>();
+        if(pack->Open(ofToDataPath("sprites.pack"))){
+            SpriteAtlas::UsePack(pack);
+        } else {
+            ofLogNotice() << "No sprites.pack found, decoding pngs (run with --bake-assets to make one)";
+        }
+    }
 
     ofSetFrameRate(60);
     ofSetBackgroundColor(ofColor::blue);
-    backgroundImage.load("background.png");
-    backgroundImage.resize(ofGetWindowWidth(), ofGetWindowHeight());
 
     
     std::shared_ptr<Aquarium> myAquarium;
@@ -16,77 +40,184 @@ void ofApp::setup(){
     gameManager = std::make_unique<GameSceneManager>();
 
 
-    // first we make the intro scene 
-    gameManager->AddScene(std::make_shared<GameIntroScene>(
+    // first we make the intro scene, the title is the only image loaded before the first frame
+    auto introScene = std::make_shared<GameIntroScene>(
         GameSceneKindToString(GameSceneKind::GAME_INTRO),
         std::make_shared<GameSprite>("title.png", ofGetWindowWidth(), ofGetWindowHeight())
-    ));
+    );
+    gameManager->AddScene<GameSceneKind::GAME_INTRO>(introScene);
+
+    // everything else is decoded by the loader while the intro is drawing
+    assetLoader = std::make_shared<AssetLoader>();
+
+    auto backgroundAtlas = GameSprite::DescribeStandalone("background.png", ofGetWindowWidth(), ofGetWindowHeight());
+    backgroundImage = std::make_shared<GameSprite>(backgroundAtlas, 0);
+    assetLoader->QueueAtlas("background", backgroundAtlas);
+
+    //AquariumSpriteManager, its atlas gets uploaded by the loader
+    spriteManager = std::make_shared<AquariumSpriteManager>(false);
+    assetLoader->QueueAtlas("creatures", spriteManager->getAtlas());
+
+    auto gameOverAtlas = GameSprite::DescribeStandalone("game-over.png", ofGetWindowWidth(), ofGetWindowHeight());
+    assetLoader->QueueAtlas("game-over", gameOverAtlas);
+
+    // Initial Music setup, sound and fonts have to be loaded on the main thread
+    assetLoader->QueueOnMainThread("music", [this](){
+        if(gameMusic.load("rainyday.mp3") && !musicChanged) {
+            gameMusic.setLoop(true);
+            gameMusic.play();
+            gameMusic.setVolume(0.75f);
+        } 
+        else {
+            ofLogError() << "Failed to load the awesome game gameMusic!";  // Added some an error message just in case
+        }
+    });
+
+    // Load font for game over message
+    assetLoader->QueueOnMainThread("font", [this](){
+        gameOverTitle.load("Verdana.ttf", 12, true, true);
+        gameOverTitle.setLineHeight(34.0f);
+        gameOverTitle.setLetterSpacing(1.035);
+    });
 
-    //AquariumSpriteManager
-    spriteManager = std::make_shared<AquariumSpriteManager>();
+    assetLoader->Start();
+    introScene->SetLoader(assetLoader, {"background", "creatures", "font"}); // SPACE waits for these, the HUD text needs the font
 
-    // Lets setup the aquarium
+    // Lets setup the aquarium, sprites only point at the atlas so this doesn't need the textures yet
     myAquarium = std::make_shared<Aquarium>(ofGetWindowWidth(), ofGetWindowHeight(), spriteManager);
     player = std::make_shared<PlayerCreature>(ofGetWindowWidth()/2 - 50, ofGetWindowHeight()/2 - 50, DEFAULT_SPEED, this->spriteManager->GetSprite(AquariumCreatureType::NPCreature));
     player->setDirection(0, 0); // Initially stationary
     player->setBounds(ofGetWindowWidth() - 20, ofGetWindowHeight() - 20);
 
-    //  Set powerUpScore values for all levels (powerup target score)
-    myAquarium->addAquariumLevel(std::make_shared<Level_0>(0, 10, 5));
-    myAquarium->addAquariumLevel(std::make_shared<Level_1>(1, 15, 7));
-    myAquarium->addAquariumLevel(std::make_shared<Level_2>(2, 20, 10));
-    myAquarium->addAquariumLevel(std::make_shared<Level_3>(3, 35, 17));   //Added implementation of level 3
-    myAquarium->addAquariumLevel(std::make_shared<Level_4>(4, 50, 25));   //Added implementation of level 4
-    myAquarium->Repopulate(); // initial population
+    std::vector<InputRecord> replay;
+    if(!replayPath.empty()){
+        InputRecordingHeader recording;
+        if(LoadInputRecording(replayPath, recording, replay)){
+            // the recording's seed and rate, otherwise the same input would meet different fish
+            seed = recording.seed;
+            tickRate = recording.tickRate;
+            player->setLives(recording.lives);
+            if(int(recording.width) != ofGetWindowWidth() || int(recording.height) != ofGetWindowHeight()){
+                ofLogWarning() << "Recorded at " << recording.width << "x" << recording.height << ", the replay will drift";
+            }
+            ofLogNotice() << "Replaying " << replay.size() << " inputs over " << recording.ticks << " ticks from " << replayPath;
+        }
+    }
+    if(seed == 0){
+        seed = ofGetSystemTimeMicros();
+    }
+    if(!recordPath.empty()){
+        recorder.Start(recordPath, seed, tickRate, ofGetWindowWidth(), ofGetWindowHeight(), player->getLives());
+    }
+    ofLogNotice() << "Aquarium seed " << seed << " (--seed " << seed << " replays the same spawns)";
+    myAquarium->setSeed(seed);
+    AddGameLevels(myAquarium); // initial population is spawned by the scene's Preload, once the intro is up
 
 
     // now that we are mostly set, lets pass the player and the aquarium downstream
-    gameManager->AddScene(std::make_shared<AquariumGameScene>(
+    auto aquariumScene = std::make_shared<AquariumGameScene>(
         std::move(player), std::move(myAquarium), GameSceneKindToString(GameSceneKind::AQUARIUM_GAME)
-    )); // player and aquarium are owned by the scene moving forward
-
-    // Initial Music setup
-    if(gameMusic.load("rainyday.mp3") && !musicChanged) {
-        gameMusic.setLoop(true);
-        gameMusic.play();
-        gameMusic.setVolume(0.75f);
-    } 
-    else {
-        ofLogError() << "Failed to load the awesome game gameMusic!";  // Added some an error message just in case
+    ); // player and aquarium are owned by the scene moving forward
+    aquariumScene->SetTickRate(tickRate);
+    aquariumScene->SetReplay(std::move(replay));
+    aquariumScene->SetRecorder(&recorder);
+    aquariumScene->SetHudFont(&gameOverTitle);
+    if(!snapshotPath.empty()){
+        aquariumScene->LoadSnapshot(snapshotPath);
     }
-
-    // Load font for game over message
-    gameOverTitle.load("Verdana.ttf", 12, true, true);
-    gameOverTitle.setLineHeight(34.0f);
-    gameOverTitle.setLetterSpacing(1.035);
+    gameManager->AddScene<GameSceneKind::AQUARIUM_GAME>(aquariumScene);
 
 
-    gameManager->AddScene(std::make_shared<GameOverScene>(
+    gameManager->AddScene<GameSceneKind::GAME_OVER>(std::make_shared<GameOverScene>(
         GameSceneKindToString(GameSceneKind::GAME_OVER),
-        std::make_shared<GameSprite>("game-over.png", ofGetWindowWidth(), ofGetWindowHeight())
+        std::make_shared<GameSprite>(gameOverAtlas, 0)
     ));
+    gameManager->AddScene<GameSceneKind::PAUSE>(std::make_shared<PauseOverlayScene>(&gameOverTitle));
+    gameManager->AddScene<GameSceneKind::HELP>(std::make_shared<HelpOverlayScene>(&gameOverTitle));
+
+    SetupLayers(ofGetWindowWidth(), ofGetWindowHeight());
+    ofSetBackgroundAuto(false); // the background layer is opaque and covers the window, a clear would be wasted fill
 
     ofSetLogLevel(OF_LOG_NOTICE); // Set default log level
 }
 
+void ofApp::SetupLayers(int w, int h){
+    // repainted when the scene changes or once the loader is done (backgrounds and banners become resident)
+    compositor.SetLayer(CompositorLayer::Background, 0, 0, w, h, [this](){
+        ScopedPhaseTimer timer(ProfilePhase::Background);
+        backgroundImage->draw(0, 0);
+        gameManager->GetActiveScene()->DrawBackground();
+    }, [this](){
+        return uint64_t(gameManager->GetActiveKind()) | uint64_t(assetLoader->IsDone()) << 8;
+    }, true);
+
+    compositor.SetLayer(CompositorLayer::Creatures, 0, 0, w, h, [this](){
+        gameManager->DrawActiveScene();
+    });
+
+    // the score panel sits in the top right corner
+    compositor.SetLayer(CompositorLayer::Hud, w - 160, 0, 160, 72, [this](){
+        ScopedPhaseTimer timer(ProfilePhase::Hud);
+        gameManager->GetActiveScene()->DrawHud();
+    }, [this](){
+        // the scene kind goes through the same FNV-1a step as the scene's values, a plain xor would only
+        // flip the low bits and two scenes' keys could meet
+        uint64_t key = (0xcbf29ce484222325ull ^ uint64_t(gameManager->GetActiveKind())) * 0x100000001b3ull;
+        uint64_t hud = gameManager->GetActiveScene()->GetHudKey();
+        for (int shift = 0; shift < 64; shift += 8) {
+            key = (key ^ ((hud >> shift) & 0xff)) * 0x100000001b3ull;
+        }
+        return key;
+    });
+
+    // help/pause texts and the hints, top left
+    compositor.SetLayer(CompositorLayer::Overlay, 0, 0, 480, 80, [this](){
+        //The help and pause texts are the overlays' own, the hints only show while they aren't up
+        if(gameManager->GetActiveKind() == GameSceneKind::AQUARIUM_GAME) {
+            if(gameManager->GetTopKind() == GameSceneKind::AQUARIUM_GAME) {
+                helpHint.Draw(&gameOverTitle);
+            }
+            if(!gameManager->HasOverlay(GameSceneKind::PAUSE)) {
+                pauseHint.Draw(&gameOverTitle);
+            }
+        }
+        gameManager->DrawOverlays();
+    }, [this](){
+        // the hints and overlays switch from bitmap text to the font once it's loaded
+        return gameManager->GetStackKey() << 1 | uint64_t(gameOverTitle.isLoaded());
+    });
+}
+
 //--------------------------------------------------------------
 void ofApp::update(){
-    if(pausePressed && gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::AQUARIUM_GAME)) return;
+    // gpu uploads for whatever the loader threads finished
+    if(!assetLoader->IsDone()){
+        assetLoader->Update();
+        if(assetLoader->IsDone()){
+            ofLogNotice() << "All assets resident at " << ofGetElapsedTimeMicros() / 1000.0 << " ms";
+        }
+    }
+
+    GameSceneKind activeKind = gameManager->GetActiveKind();
+    // the first population spawns while the title is still up, SPACE then only has to switch scenes
+    if(activeKind == GameSceneKind::GAME_INTRO){
+        gameManager->Preload(GameSceneKind::AQUARIUM_GAME);
+    }
+
+    if(gameManager->HasOverlay(GameSceneKind::PAUSE)) return;
 
-    if(gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::GAME_OVER)){
+    if(activeKind == GameSceneKind::GAME_OVER){
         if(gameMusic.isPlaying()) {
             gameMusic.stop();
         }
         return; // Stop updating if game is over or exiting. The music also stops once game is over.
     }
 
-    if(gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::AQUARIUM_GAME)){
-        auto gameScene = std::static_pointer_cast<AquariumGameScene>(gameManager->GetActiveScene());
+    if(activeKind == GameSceneKind::AQUARIUM_GAME){
+        AquariumGameScene* gameScene = gameManager->Get<GameSceneKind::AQUARIUM_GAME>();
 
-        //Calculated time passed per each frame and added it to the timer
-        //Since the game runs at 60FPS, one we have 60 frames we will have a second
-        //Didn't use openFrameworks function since I did not like how they calculated the time elapsed 
-         musicTimer +=  1.0f/60.0f;
+        //Real time of the last frame added to the timer, so slow frames don't stretch the minute
+         musicTimer += ofGetLastFrameTime();
 
         //Music will change once we have hit one minute of actual gameplay, not including intro
         if(musicTimer >= 60.0f && !musicChanged) {
@@ -102,8 +233,9 @@ void ofApp::update(){
             }
         }
 
-        if(gameScene->GetLastEvent() != nullptr && gameScene->GetLastEvent()->isGameOver()){
-            gameManager->Transition(GameSceneKindToString(GameSceneKind::GAME_OVER));
+        if(gameScene->GetLastEvent().isGameOver()){
+            FinishRecording();
+            gameManager->Transition(GameSceneKind::GAME_OVER);
             return;
         }
     } 
@@ -113,37 +245,35 @@ void ofApp::update(){
 
 //--------------------------------------------------------------
 void ofApp::draw(){
-    backgroundImage.draw(0, 0);
-    gameManager->DrawActiveScene();
-
-    //If flag is true the instructions text will appear if in game mode
-    //Once in pause state, literally everything is paused
-    if(helpedPressed && gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::AQUARIUM_GAME) && !pausePressed) {
-        ofDrawBitmapString("Use the arrow keys to move your fish around!", 5, 20);  //Added instructions in overlay to improve user experience
-        ofDrawBitmapString("PowerUps might appear at some points...", 5, 30);
-    
-    //Needed so that text would only appear when the instructions text is not present and within the actual game, not intro
-    } else if(!helpedPressed && gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::AQUARIUM_GAME) && !pausePressed) {
-        ofDrawBitmapString("Press H to obtain help!!", 5, 20);
-    }
-    //Since in pause state everything stops, no help is available to make things, more interesting....
-    else if(gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::AQUARIUM_GAME) && pausePressed) {
-        ofDrawBitmapString("Help not available. No advantages here...", 5, 20);
+    RenderStats::NewFrame();
+    if(Profiler::IsEnabled()){
+        Profiler::Record(ProfilePhase::Frame, uint64_t(ofGetLastFrameTime() * 1e9));
     }
-    //If flag is true and within game mode, the pause text will appear
-    if(pausePressed && gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::AQUARIUM_GAME)) {
-        ofDrawBitmapString("Press P to unpause game!", 5, 50);
-        ofDrawBitmapString("You can now breathe...", 5, 60);
+    compositor.Draw();
+    if(gameManager->GetActiveKind() == GameSceneKind::AQUARIUM_GAME){
+        gameManager->Get<GameSceneKind::AQUARIUM_GAME>()->PresentInput(ofGetElapsedTimeMicros());
     }
-    //If flag is false and within game mode, the pause text will change and extra text will be gone... (maybe forever)
-    else if(!pausePressed && gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::AQUARIUM_GAME)) {
-        ofDrawBitmapString("Press P to pause game!", 5, 50);
+
+    // startup measurement, compare a launch with sprites.pack against one with --no-pack
+    if(!firstFrameDrawn){
+        firstFrameDrawn = true;
+        ofLogNotice() << "Startup (" << (useAssetPack ? "asset pack" : "png decode") << "): first frame at "
+                      << ofGetElapsedTimeMicros() / 1000.0 << " ms";
     }
 }
 
 //--------------------------------------------------------------
 void ofApp::exit(){
-    
+    FinishRecording();
+    if(AquariumGameScene* gameScene = gameManager->Get<GameSceneKind::AQUARIUM_GAME>()){
+        gameScene->PrintInputLatency();
+    }
+}
+
+void ofApp::FinishRecording(){
+    if(!recorder.isRecording()) return;
+    AquariumGameScene* gameScene = gameManager->Get<GameSceneKind::AQUARIUM_GAME>();
+    recorder.Finish(gameScene ? gameScene->GetTick() : 0);
 }
 
 //--------------------------------------------------------------
@@ -152,43 +282,59 @@ void ofApp::keyPressed(int key){
         ofLogNotice() << "Game has ended. Press ESC to exit." << std::endl;
         return; // Ignore other keys after game over
     }
-    //Added pausePressed condition if not player could move under pause conditions and no cheating!!!
-    if(gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::AQUARIUM_GAME) && !pausePressed){
-        auto gameScene = std::static_pointer_cast<AquariumGameScene>(gameManager->GetActiveScene());
-        switch(key){
-            case OF_KEY_UP:
-                gameScene->GetPlayer()->setDirection(gameScene->GetPlayer()->isXDirectionActive()?gameScene->GetPlayer()->getDx():0, -1);
-                break;
-                case OF_KEY_DOWN:
-                gameScene->GetPlayer()->setDirection(gameScene->GetPlayer()->isXDirectionActive()?gameScene->GetPlayer()->getDx():0, 1);
-                break;
-            case OF_KEY_LEFT:
-                gameScene->GetPlayer()->setDirection(-1, gameScene->GetPlayer()->isYDirectionActive()?gameScene->GetPlayer()->getDy():0);
-                gameScene->GetPlayer()->setFlipped(true);
-                break;
-                case OF_KEY_RIGHT:
-                gameScene->GetPlayer()->setDirection(1, gameScene->GetPlayer()->isYDirectionActive()?gameScene->GetPlayer()->getDy():0);
-                gameScene->GetPlayer()->setFlipped(false);
-                break;
-            default:
-                break;
+    //Added pause condition if not player could move under pause conditions and no cheating!!!
+    if(gameManager->GetActiveKind() == GameSceneKind::AQUARIUM_GAME && !gameManager->HasOverlay(GameSceneKind::PAUSE)){
+        AquariumGameScene* gameScene = gameManager->Get<GameSceneKind::AQUARIUM_GAME>();
+        // the arrows only queue up, the scene applies them before its next tick (a replay ignores them)
+        if(key == OF_KEY_UP || key == OF_KEY_DOWN || key == OF_KEY_LEFT || key == OF_KEY_RIGHT){
+            gameScene->PushInput(key, true, ofGetElapsedTimeMicros());
+        }
+
+        // memory footprint per subsystem to the log
+        if(key == 'm' || key == 'M') {
+            gameScene->GetAquarium()->GetMemoryReport().print();
+        }
+
+        // frame phase profiler overlay
+        if(key == 'f' || key == 'F') {
+            Profiler::Toggle();
+        }
+
+        // binary event trace, dumped when it's turned off (decode it with --decode-trace)
+        if(key == 't' || key == 'T') {
+            if(Trace::IsEnabled()) {
+                Trace::SetEnabled(false);
+                Trace::Dump(ofToDataPath("trace.aqtr"));
+            } else {
+                Trace::SetEnabled(true);
+                ofLogNotice() << "Tracing, press T again to dump it";
+            }
+        }
+
+        // quick save / quick load
+        if(key == OF_KEY_F5) {
+            gameScene->SaveSnapshot(ofToDataPath("quicksave.aqss"));
+        }
+        if(key == OF_KEY_F9 && gameScene->LoadSnapshot(ofToDataPath("quicksave.aqss")) && recorder.isRecording()) {
+            ofLogWarning() << "Loaded a snapshot while recording, the recording won't replay past this point";
         }
 
         //Player must keep key pressed to see instructions text
         if(key == 'h' || key == 'H') {
-            helpedPressed = true;
+            gameManager->PushOverlay(GameSceneKind::HELP);
         }
-
-        gameScene->GetPlayer()->move();
         return;
 
     }
 
-    if(gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::GAME_INTRO)){
+    if(gameManager->GetActiveKind() == GameSceneKind::GAME_INTRO){
         switch (key)
         {
         case OF_KEY_SPACE:
-            gameManager->Transition(GameSceneKindToString(GameSceneKind::AQUARIUM_GAME));
+            // can't start until the aquarium assets are uploaded
+            if(gameManager->Get<GameSceneKind::GAME_INTRO>()->IsReady()){
+                gameManager->Transition(GameSceneKind::AQUARIUM_GAME);
+            }
             break;
         
         default:
@@ -203,27 +349,25 @@ void ofApp::keyPressed(int key){
 
 //--------------------------------------------------------------
 void ofApp::keyReleased(int key){
-    if(gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::AQUARIUM_GAME)){
-        auto gameScene = std::static_pointer_cast<AquariumGameScene>(gameManager->GetActiveScene());
-    if( key == OF_KEY_UP || key == OF_KEY_DOWN){
-        gameScene->GetPlayer()->setDirection(gameScene->GetPlayer()->isXDirectionActive()?gameScene->GetPlayer()->getDx():0, 0);
-        gameScene->GetPlayer()->move();
-        return;
-    }
-    
-    if(key == OF_KEY_LEFT || key == OF_KEY_RIGHT){
-        gameScene->GetPlayer()->setDirection(0, gameScene->GetPlayer()->isYDirectionActive()?gameScene->GetPlayer()->getDy():0);
-        gameScene->GetPlayer()->move();
+    if(gameManager->GetActiveKind() == GameSceneKind::AQUARIUM_GAME){
+        AquariumGameScene* gameScene = gameManager->Get<GameSceneKind::AQUARIUM_GAME>();
+    if(key == OF_KEY_UP || key == OF_KEY_DOWN || key == OF_KEY_LEFT || key == OF_KEY_RIGHT){
+        gameScene->PushInput(key, false, ofGetElapsedTimeMicros());
         return;
     }
     //Once player releases key, text will dissapear to make the game more visable and not have a lot of text
     if(key == 'H' || key == 'h') {
-        helpedPressed = false;
+        gameManager->RemoveOverlay(GameSceneKind::HELP);
     }
 
-    //If player presses key once the pause state is activated
+    //If player presses key once the pause state is activated, help isn't available while paused
     if(key == 'P' || key == 'p') {
-    pausePressed = !pausePressed;
+        if(gameManager->HasOverlay(GameSceneKind::PAUSE)) {
+            gameManager->RemoveOverlay(GameSceneKind::PAUSE);
+        } else {
+            gameManager->RemoveOverlay(GameSceneKind::HELP);
+            gameManager->PushOverlay(GameSceneKind::PAUSE);
+        }
     }
 
     }
@@ -266,10 +410,13 @@ void ofApp::mouseExited(int x, int y){
 
 //--------------------------------------------------------------
 void ofApp::windowResized(int w, int h){
-    backgroundImage.resize(w, h);
-    auto aquariumScene = std::static_pointer_cast<AquariumGameScene>(gameManager->GetScene(GameSceneKindToString(GameSceneKind::AQUARIUM_GAME)));
+    if(assetLoader->IsResident("background")){ // otherwise the loader still owns the old one
+        backgroundImage = std::make_shared<GameSprite>("background.png", w, h);
+    }
+    AquariumGameScene* aquariumScene = gameManager->Get<GameSceneKind::AQUARIUM_GAME>();
     aquariumScene->GetAquarium()->setBounds(w,h);
     aquariumScene->GetPlayer()->setBounds(w - 20, h - 20);
+    SetupLayers(w, h); // new FBO sizes, everything cached gets painted again
 
 }
 
@@ -2,6 +2,8 @@
 
 #include "ofMain.h"
 #include "Aquarium.h"
+#include "AssetLoader.h"
+#include "Compositor.h"
 
 
 class ofApp : public ofBaseApp{
@@ -24,6 +26,21 @@ class ofApp : public ofBaseApp{
 		void windowResized(int w, int h) override;
 		void dragEvent(ofDragInfo dragInfo) override;
 		void gotMessage(ofMessage msg) override;
+
+		// Build step: writes every sprite page at its target size into a raw RGBA pack
+		static bool BakeAssets(const std::string& packPath, int width, int height);
+		void FinishRecording();
+		// the compositor's layers for a window of w x h (setup and resizes)
+		void SetupLayers(int w, int h);
+
+		bool useAssetPack = true;  // --no-pack forces the png path, handy to compare startup times
+		bool firstFrameDrawn = false;
+		double tickRate = 60.0;    // --tick-rate, simulation ticks per second
+		uint64_t seed = 0;         // --seed for the aquarium's random streams, 0 picks one from the clock
+		std::string recordPath;    // --record, the session's input (applied by the scene) is written here on exit
+		std::string replayPath;    // --replay, plays a recording back at real speed instead of the keyboard
+		InputRecorder recorder;
+		std::string snapshotPath;  // --snapshot, the game starts from this save
 	
 		
 		char moveDirection;
@@ -36,19 +53,20 @@ class ofApp : public ofBaseApp{
 		GameEvent lastEvent;
 
 
-		ofImage backgroundImage;
+		std::shared_ptr<GameSprite> backgroundImage;
 		ofSoundPlayer gameMusic;  // Needed variable for music setup
 
 		std::unique_ptr<GameSceneManager> gameManager;
+		Compositor compositor;
+		// key hints over the game, same font as the HUD (gameOverTitle)
+		HudText helpHint{"Press H to obtain help!!", 5, 20};
+		HudText pauseHint{"Press P to pause game!", 5, 52};
 		std::shared_ptr<AquariumSpriteManager>spriteManager;
+		std::shared_ptr<AssetLoader> assetLoader;
 
 		bool musicChanged = false; //Flag that will allow to change music in the future
 
 		float musicTimer = 0.0f;  //Timer that will be needed to change son after x amount of time passed
-
-		bool helpedPressed = false;  //Flag that will allow to detect if user asks for help
-
-		bool pausePressed = false;  //Flag that will help activate pause state
-									//Since pause state is the same, decided to use a flag instead of declaring a new state....
+		//Help and pause are overlay scenes pushed on top of the game (GameSceneKind::HELP / PAUSE)
 		
 };